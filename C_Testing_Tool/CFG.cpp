@@ -32,10 +32,10 @@ void CFG::addNode(int id, CodeLine code)
     nodes[id] = Node(id, code);
 }
 
-// Add edge to CFG: for existing nodes only!
+// Add edge to CFG: for existing nodes only! A return statement has no successors
 void CFG::addEdge(int idFrom, int idTo, CodeLine cnd)
 {
-    if (findNode(idFrom) && findNode(idTo))
+    if (findNode(idFrom) && findNode(idTo) && nodes[idFrom].code.front().getLexeme() != LEX_RETURN)
     {
         nodes[idFrom].edges.push_back(Edge(idTo, cnd));
     }
@@ -272,7 +272,10 @@ void CFGBuilder::breakdownEntryLoop(CodeLine cnd, int branchId)
         }
     }
     potentialEdges.push_back(make_tuple(branchId, currId, extractFromCndStack()));
-    potentialEdges.push_back(make_tuple(currId - 1, branchId, CodeLine{}));
+    if (prevId != -1)                                          // A nested loop at the end of the body already leads back to the branch node
+    {
+        potentialEdges.push_back(make_tuple(currId - 1, branchId, CodeLine{}));
+    }
 }
 
 // Breakdown entry loop (do { ... } while())
@@ -443,6 +446,7 @@ bool CFGBuilder::breakdownSingleLine()
 CFGBuilder::CFGBuilder(vector<Token> sourceCode)
 {
     currId = 1;
+    prevId = 0;
     isBranch = false;
 
     vector<Token> code = sourceCode;
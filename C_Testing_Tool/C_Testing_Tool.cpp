@@ -6,7 +6,11 @@ int main()
         "Lexical Analysis",
         "Syntax and Semantic Analysis",
         "Statement Coverage Test",
-        "Branch Coverage Test"
+        "Branch Coverage Test",
+        "Statement Coverage Test (Bounded Model Checking)",
+        "Branch Coverage Test (Bounded Model Checking)",
+        "Solver Preset Benchmark",
+        "Replay Captured Queries"
     };
 
     UserInterface UI(currentTestOptions);
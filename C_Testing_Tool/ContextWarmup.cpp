@@ -0,0 +1,64 @@
+#include "ContextWarmup.h"
+
+//.........................CONTEXT WARMUP CLASS
+
+// Constructor. Starts the warm-up thread with the arithmetic the solver is going to use
+ContextWarmup::ContextWarmup(bool bitVectors)
+{
+    warmupTime = 0;
+    waitTime = 0;
+    worker = std::thread(&ContextWarmup::run, this, bitVectors);
+}
+
+// Destructor. A context that was never taken is released after the thread ends
+ContextWarmup::~ContextWarmup()
+{
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+// Create the context and check a query over the sorts of the variables, which initializes
+// the global state of Z3 and the solver kernel
+void ContextWarmup::run(bool bitVectors)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<context> fresh(new context);
+    try
+    {
+        solver s(*fresh);
+        expr x = bitVectors ? fresh->bv_const("x", 32) : fresh->int_const("x");
+        expr y = bitVectors ? fresh->bv_const("y", 32) : fresh->int_const("y");
+        s.add(x + y == 10 && x > y);
+        s.check();
+    }
+    catch (z3::exception&)
+    {
+        // The context is still usable, only colder
+    }
+    ctx = std::move(fresh);
+    warmupTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Wait for the warm-up to end and take the context. Returns null if it was taken already
+std::unique_ptr<context> ContextWarmup::take()
+{
+    if (worker.joinable())
+    {
+        auto start = std::chrono::steady_clock::now();
+        worker.join();
+        waitTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return std::move(ctx);
+}
+
+double ContextWarmup::getWarmupTime() const
+{
+    return warmupTime;
+}
+
+double ContextWarmup::getWaitTime() const
+{
+    return waitTime;
+}
@@ -0,0 +1,34 @@
+#ifndef CONTEXTWARMUP_H
+#define CONTEXTWARMUP_H
+
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <z3++.h>
+
+using namespace z3;
+
+// Creates a Z3 context on a background thread and solves a small query in it, so that the
+// start-up costs of Z3 overlap with the lexing, parsing and CFG construction of the front end.
+// The context is used by one thread at a time: the warm-up thread until it ends, then the
+// thread that takes it
+class ContextWarmup
+{
+    std::unique_ptr<context> ctx;
+    std::thread worker;
+    double warmupTime;                                  // Milliseconds the warm-up thread ran
+    double waitTime;                                    // Milliseconds the taking thread waited for it
+
+    void run(bool bitVectors);
+
+public:
+    ContextWarmup(bool bitVectors);
+    ~ContextWarmup();
+
+    std::unique_ptr<context> take();
+
+    double getWarmupTime() const;
+    double getWaitTime() const;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "CounterexampleCache.h"
+
+// Constructor
+CounterexampleCache::CounterexampleCache(int recentModels) : recentModels(recentModels) {}
+
+// Normalize the query to a sorted set of AST IDs. Trivially true constraints are dropped
+std::vector<unsigned> CounterexampleCache::makeKey(const std::vector<expr>& query)
+{
+    std::vector<unsigned> key;
+    for (auto& constraint : query)
+    {
+        if (!constraint.is_true())
+        {
+            key.push_back(constraint.id());
+        }
+    }
+    std::sort(key.begin(), key.end());
+    key.erase(std::unique(key.begin(), key.end()), key.end());
+    return key;
+}
+
+// Check whether the model satisfies every constraint of the query
+bool CounterexampleCache::satisfies(const model& m, const std::vector<expr>& query)
+{
+    for (auto& constraint : query)
+    {
+        if (!m.eval(constraint, true).is_true())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Answer the query from the cache. Returns unknown on a miss
+check_result CounterexampleCache::lookup(const std::vector<expr>& query, model& m)
+{
+    std::vector<unsigned> key = makeKey(query);
+    auto it = index.find(key);
+    if (it != index.end())
+    {
+        const CacheEntry& entry = entries.at(it->second);
+        if (entry.result == sat)
+        {
+            m = models.at(entry.modelIndex);
+        }
+        return entry.result;
+    }
+
+    // A superset of an unsatisfiable set is unsatisfiable
+    for (auto& entryIndex : unsatEntries)
+    {
+        const std::vector<unsigned>& unsatKey = entries.at(entryIndex).key;
+        if (std::includes(key.begin(), key.end(), unsatKey.begin(), unsatKey.end()))
+        {
+            return unsat;
+        }
+    }
+
+    // A subset of a satisfiable set is satisfied by its model, and so may be a set close to it
+    int first = std::max(0, (int) satEntries.size() - recentModels);
+    for (int i = (int) satEntries.size() - 1; i >= first; i--)
+    {
+        const CacheEntry& entry = entries.at(satEntries.at(i));
+        const model& candidate = models.at(entry.modelIndex);
+        if (std::includes(entry.key.begin(), entry.key.end(), key.begin(), key.end()) || satisfies(candidate, query))
+        {
+            m = candidate;
+            addEntry(key, query, sat, entry.modelIndex);
+            return sat;
+        }
+    }
+    return unknown;
+}
+
+// Add entry for the query. Only entries with a new model are tried on later queries
+void CounterexampleCache::addEntry(const std::vector<unsigned>& key, const std::vector<expr>& query, check_result result, int modelIndex)
+{
+    CacheEntry entry;
+    entry.key = key;
+    entry.constraints = query;
+    entry.result = result;
+    entry.modelIndex = modelIndex;
+    index[key] = entries.size();
+    entries.push_back(entry);
+}
+
+// Store result of a query answered by the solver
+void CounterexampleCache::insert(const std::vector<expr>& query, check_result result, const model& m)
+{
+    if (result == sat)
+    {
+        satEntries.push_back(entries.size());
+        addEntry(makeKey(query), query, sat, models.size());
+        models.push_back(m);
+    }
+    else if (result == unsat)
+    {
+        unsatEntries.push_back(entries.size());
+        addEntry(makeKey(query), query, unsat, -1);
+    }
+}
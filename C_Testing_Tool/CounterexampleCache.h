@@ -0,0 +1,42 @@
+#ifndef COUNTEREXAMPLECACHE_H
+#define COUNTEREXAMPLECACHE_H
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <z3++.h>
+
+using namespace z3;
+
+// Results of earlier solver queries, keyed by the set of their constraints.
+// A query is answered without the solver if it contains a known unsatisfiable set,
+// is contained in a known satisfiable set, or is satisfied by a recently stored model
+class CounterexampleCache
+{
+    struct CacheEntry
+    {
+        std::vector<unsigned> key;                      // Sorted AST IDs of the constraints
+        std::vector<expr> constraints;                  // Keeps the AST IDs of the key alive
+        check_result result;
+        int modelIndex;                                 // Index in models for satisfiable sets
+    };
+
+    std::vector<CacheEntry> entries;
+    std::map<std::vector<unsigned>, int> index;         // Entry by key
+    std::vector<int> unsatEntries;
+    std::vector<int> satEntries;
+    std::vector<model> models;
+    int recentModels;                                   // Number of latest models tried on a new query
+
+    std::vector<unsigned> makeKey(const std::vector<expr>& query);
+    bool satisfies(const model& m, const std::vector<expr>& query);
+    void addEntry(const std::vector<unsigned>& key, const std::vector<expr>& query, check_result result, int modelIndex);
+
+public:
+    CounterexampleCache(int recentModels = 16);
+
+    check_result lookup(const std::vector<expr>& query, model& m);
+    void insert(const std::vector<expr>& query, check_result result, const model& m);
+};
+
+#endif
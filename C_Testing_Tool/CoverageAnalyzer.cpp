@@ -57,23 +57,11 @@ bool compareCodelines(CodeLine line1, CodeLine line2)
 }
 
 
-//.........................COVERAGE ANALYZER CLASS
-
-// Detect unreachable code lines
-void CoverageAnalyzer::findDeadCodeNodes()
+// Get numbers of the code lines of the nodes
+vector<int> getLineNums(CFG& cfg, const vector<int>& nodeIds)
 {
-    int idMax = cfg.nodes.size();
-    vector<int> deadCodeNodes;
-    for (int id = 1; id <= idMax; id++)
-    {
-        auto it = find(visitedNodes.begin(), visitedNodes.end(), id);
-        if (it == visitedNodes.end())
-        {
-            deadCodeNodes.push_back(id);
-        }
-    }
     vector<int> lineNums;
-    for (auto& id : deadCodeNodes)
+    for (auto& id : nodeIds)
     {
         Node currNode = cfg.nodes[id];
         for (auto& token : currNode.code)
@@ -85,8 +73,13 @@ void CoverageAnalyzer::findDeadCodeNodes()
             }
         }
     }
+    return lineNums;
+}
 
-    cout << "Warning: Unreachable code detected in" << (lineNums.size() > 1 ? " lines " : " line ") << lineNums.front();
+// Print the message followed by the line numbers
+void printLineNums(const string& message, const vector<int>& lineNums)
+{
+    cout << message << (lineNums.size() > 1 ? " lines " : " line ") << lineNums.front();
     for (int i = 1; i < lineNums.size(); i++)
     {
         cout << ", " << lineNums.at(i);
@@ -94,6 +87,66 @@ void CoverageAnalyzer::findDeadCodeNodes()
     cout << "\n";
 }
 
+
+//.........................COVERAGE ANALYZER CLASS
+
+// Report the nodes and branches interval analysis proves dead, before the solver starts
+void CoverageAnalyzer::reportStaticDeadCode(Solver& solver)
+{
+    set<int> deadNodes = solver.getDeadNodes();
+    staticDeadNodes = deadNodes;
+    vector<int> neverTaken;                             // Branching nodes with a dead edge to a live node
+    for (auto& edge : solver.getDeadEdges())
+    {
+        if (!deadNodes.count(edge.first) && !deadNodes.count(edge.second) &&
+            find(neverTaken.begin(), neverTaken.end(), edge.first) == neverTaken.end())
+        {
+            neverTaken.push_back(edge.first);
+        }
+    }
+    if (!deadNodes.empty())
+    {
+        printLineNums("Interval analysis: unreachable code in", getLineNums(cfg, vector<int>(deadNodes.begin(), deadNodes.end())));
+    }
+    if (!neverTaken.empty())
+    {
+        printLineNums("Interval analysis: branch never taken in", getLineNums(cfg, neverTaken));
+    }
+    cout.flush();
+}
+
+// Detect unreachable code lines. Lines the solver could not decide within the budget are unknown, not dead,
+// unless interval analysis proved them unreachable
+void CoverageAnalyzer::findDeadCodeNodes()
+{
+    int idMax = cfg.nodes.size();
+    vector<int> deadCodeNodes;
+    vector<int> unknownCodeNodes;
+    for (int id = 1; id <= idMax; id++)
+    {
+        auto it = find(visitedNodes.begin(), visitedNodes.end(), id);
+        if (it == visitedNodes.end())
+        {
+            if (unknownNodes.count(id) && !staticDeadNodes.count(id))
+            {
+                unknownCodeNodes.push_back(id);
+            }
+            else
+            {
+                deadCodeNodes.push_back(id);
+            }
+        }
+    }
+    if (!deadCodeNodes.empty())
+    {
+        printLineNums("Warning: Unreachable code detected in", getLineNums(cfg, deadCodeNodes));
+    }
+    if (!unknownCodeNodes.empty())
+    {
+        printLineNums("Unknown: not explored within the budget in", getLineNums(cfg, unknownCodeNodes));
+    }
+}
+
 // Perform statement coverage
 void CoverageAnalyzer::C0()
 {
@@ -143,7 +196,7 @@ void CoverageAnalyzer::C0()
             }
         }
     }
-    double coverageRate = 100.0 * visitedNodes.size() / cfg.nodes.size();
+    coverageRate = 100.0 * visitedNodes.size() / cfg.nodes.size();
     cout << fixed << setprecision(2) << "Statement coverage: " << coverageRate << "%\n";
 
     vector<TestCase> testSuite;
@@ -210,7 +263,7 @@ void CoverageAnalyzer::C1()
             testSuite.push_back(testCase);
         }
     }
-    double coverageRate = 100.0 * visitedBranches.size() / edges.size();
+    coverageRate = 100.0 * visitedBranches.size() / edges.size();
     cout << fixed << setprecision(2) << "Branch coverage " << coverageRate << "%\n";
     printTable(testSuite);
     if (coverageRate == 100.0)
@@ -243,6 +296,18 @@ void CoverageAnalyzer::printTable(vector<TestCase> testSuite)
         row.push_back(inputParams);
         row.push_back(testCase.getOutput());
         table.push_back(row);
+        for (int variant = 0; variant < testCase.getVariantCount(); variant++)  // Other inputs of the same path
+        {
+            vector<string> variantRow{ to_string(caseNum) + "." + to_string(variant + 2) };
+            string variantParams;
+            for (int i = 0; i < testCase.getSize(); i++)
+            {
+                variantParams = variantParams + testCase.getId(i).getName() + " = " + testCase.getVariantValue(variant, i) + "; ";
+            }
+            variantRow.push_back(variantParams);
+            variantRow.push_back(testCase.getVariantOutput(variant));
+            table.push_back(variantRow);
+        }
         caseNum++;
     }
 
@@ -301,23 +366,158 @@ void CoverageAnalyzer::printTable(vector<TestCase> testSuite)
     cout << bar << "\n";
 }
 
-// Constructor
-CoverageAnalyzer::CoverageAnalyzer(string fileName, int maxIterForLoops)
+// Print solver counters
+void CoverageAnalyzer::printSolverStats()
+{
+    int checksTotal = solverStats.checkCalls + solverStats.checksSaved;
+    cout << "Solver checks: " << solverStats.checkCalls << " issued, " << solverStats.checksSaved << " saved";
+    if (checksTotal > 0)
+    {
+        cout << fixed << setprecision(2) << " (" << 100.0 * solverStats.checksSaved / checksTotal << "%)";
+    }
+    cout << "\n";
+    int constraintsTotal = solverStats.constraintsSent + solverStats.constraintsSliced;
+    if (constraintsTotal > 0)
+    {
+        cout << "Constraints: " << solverStats.constraintsSent << " sent, " << solverStats.constraintsSliced << " sliced away";
+        cout << fixed << setprecision(2) << " (" << 100.0 * solverStats.constraintsSliced / constraintsTotal << "%)\n";
+    }
+    int cacheHits = solverStats.cacheHits + solverStats.diskCacheHits;
+    int queriesTotal = cacheHits + solverStats.cacheMisses;
+    if (queriesTotal > 0)
+    {
+        cout << "Query cache: " << solverStats.cacheHits << " hits, " << solverStats.diskCacheHits << " disk hits, ";
+        cout << solverStats.cacheMisses << " misses";
+        cout << fixed << setprecision(2) << " (" << 100.0 * cacheHits / queriesTotal << "% hit rate)\n";
+    }
+    int presolverTotal = solverStats.queriesPresolved + solverStats.queriesSent;
+    if (solverStats.queriesPresolved > 0)
+    {
+        cout << "Pre-solver: " << solverStats.queriesPresolved << " of " << presolverTotal << " queries decided without Z3";
+        cout << fixed << setprecision(2) << " (" << 100.0 * solverStats.queriesPresolved / presolverTotal << "%)\n";
+    }
+    if (solverStats.queriesUnknown > 0 || budgetExhausted)
+    {
+        cout << "Z3 queries: " << solverStats.queriesSent << " sent, " << solverStats.queriesUnknown << " unknown\n";
+    }
+    if (solverStats.queriesCaptured > 0)
+    {
+        cout << "Captured: " << solverStats.queriesCaptured << " queries written to " << options.captureDirectory << "\n";
+    }
+    if (solverStats.extraModels > 0)
+    {
+        cout << "Extra models: " << solverStats.extraModels << " inputs beyond the first of a path\n";
+    }
+    if (solverStats.contextsRecycled > 0)
+    {
+        cout << "Context recycling: " << solverStats.contextsRecycled << " fresh contexts in ";
+        cout << fixed << setprecision(2) << solverStats.recycleTime << " ms\n";
+    }
+    if (solverStats.portfolioRaces > 0)
+    {
+        cout << "Portfolio: " << solverStats.portfolioRaces << " races";
+        for (auto& wins : solverStats.portfolioWins)
+        {
+            cout << ", " << wins.first << " won " << wins.second;
+        }
+        cout << "\n";
+    }
+    if (budgetExhausted)
+    {
+        cout << "Budget exhausted: the coverage above is partial\n";
+    }
+    if (solverStats.pathsSkipped > 0)
+    {
+        cout << "Paths skipped: " << solverStats.pathsSkipped << " adding no coverage\n";
+    }
+    if (solverStats.coresRecorded > 0)
+    {
+        cout << "Unsat cores: " << solverStats.coresRecorded << " recorded, " << solverStats.pathsPruned << " paths pruned\n";
+    }
+    if (solverStats.statesMerged > 0)
+    {
+        cout << "States merged: " << solverStats.statesMerged << "\n";
+    }
+    if (solverStats.unrolledNodes > 0)
+    {
+        cout << "Unrolled CFG: " << solverStats.unrolledNodes << " node copies\n";
+    }
+    if (solverStats.deadEdges + solverStats.deadNodes > 0)
+    {
+        cout << "Interval analysis: " << solverStats.deadEdges << " edges and " << solverStats.deadNodes << " nodes proved dead";
+        cout << fixed << setprecision(2) << " in " << solverStats.analysisTime << " ms\n";
+    }
+    if (solverStats.assignmentsSliced > 0)
+    {
+        cout << "Static slice: " << solverStats.statementsSliced << " statements skipped, ";
+        cout << solverStats.assignmentsSliced << " assignments dropped as irrelevant\n";
+    }
+    if (solverStats.loopsSummarized + solverStats.loopsUnrolled > 0)
+    {
+        cout << "Loops: " << solverStats.loopsSummarized << " summarized, " << solverStats.loopsUnrolled << " unrolled\n";
+    }
+    if (!loopBounds.empty())
+    {
+        cout << "Loop bounds:";
+        for (auto& bound : loopBounds)
+        {
+            int lineNum = cfg.nodes[bound.first].code.front().getStartPosition().lineNum;
+            cout << " line " << lineNum << " - " << bound.second << " iterations;";
+        }
+        cout << "\n";
+    }
+    cout << "Solving time: " << fixed << setprecision(2) << solvingTime << " ms\n";
+}
+
+// Constructor. The Z3 context is warmed up on another thread while the front end runs
+CoverageAnalyzer::CoverageAnalyzer(string fileName, int maxIterForLoops, SolverOptions options) :
+    maxIterForLoops(maxIterForLoops), options(options)
 {
+    auto start = chrono::steady_clock::now();
+    if (options.warmupContext)
+    {
+        warmup.reset(new ContextWarmup(options.machineArithmetic));
+    }
     Parser parser(fileName);
 
     auto res = parser.analyze();
 
 	CFGBuilder builder(res.sourceCode);
     cfg = builder.buildCFG();
+    tables = res.tables;
+    frontEndTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    startupTime = 0;
+    solvingTime = 0;
+    coverageRate = 0;
+    budgetExhausted = false;
+}
 
+// Find test cases for the coverage goal. The solver stops once the reachable targets are covered
+void CoverageAnalyzer::solve(coverageGoal goal)
+{
+    options.goal = goal;
+    auto setupStart = chrono::steady_clock::now();
     Solver solver(
         cfg,
-        res.tables.ids,
-        res.tables.charConsts,
-        res.tables.strConsts
+        tables.ids,
+        tables.charConsts,
+        tables.strConsts,
+        maxIterForLoops,
+        options,
+        warmup ? warmup->take() : nullptr
     );
+    startupTime = frontEndTime + chrono::duration<double, milli>(chrono::steady_clock::now() - setupStart).count();
+    if (options.intervalAnalysis)
+    {
+        reportStaticDeadCode(solver);
+    }
+    auto start = chrono::steady_clock::now();
     pathsAndCasesTable = solver.getPathsAndCases();                     // Import all paths and models from the SMT solver
+    solvingTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    solverStats = solver.getStats();
+    loopBounds = solver.getLoopBounds();
+    unknownNodes = solver.getUnknownNodes();
+    budgetExhausted = solver.isBudgetExhausted();
     std::sort(                                                          // Sort them by path length    
         pathsAndCasesTable.begin(),
         pathsAndCasesTable.end(),
@@ -336,14 +536,81 @@ void CoverageAnalyzer::analyze(int testOption)
     switch (testOption)
     {
     case 0:
+        solve(GOAL_STATEMENTS);
         C0();
         break;
 
     case 1:
+        solve(GOAL_BRANCHES);
         C1();
         break;
 
     default:
         break;
     }
+    printSolverStats();
+}
+
+// Run the coverage test of every file under every named set of options and print a comparison table.
+// The reports of the runs are not printed, and the on-disk query cache is off so that no run reuses another's answers.
+// Startup is the time until the solver is ready; the saving is the part of the Z3 warm-up that ran
+// during the front end, which a run creating its context after the front end would wait for
+void CoverageAnalyzer::benchmark(const vector<string>& fileNames, const vector<pair<string, SolverOptions>>& configurations, int testOption)
+{
+    const int nameWidth = 24;
+    const int columnWidth = 12;
+    cout << left << setw(nameWidth) << "File" << setw(nameWidth) << "Configuration";
+    cout << right << setw(columnWidth) << "Coverage" << setw(columnWidth) << "Time, ms";
+    cout << setw(columnWidth) << "Z3 queries" << setw(columnWidth) << "Unknown";
+    cout << setw(columnWidth) << "Startup, ms" << setw(columnWidth) << "Saved, ms" << "\n";
+
+    vector<double> totalTimes(configurations.size(), 0);
+    vector<double> totalCoverage(configurations.size(), 0);
+    vector<double> totalStartup(configurations.size(), 0);
+    vector<double> totalSaved(configurations.size(), 0);
+    for (auto& fileName : fileNames)
+    {
+        string shortName = fileName.substr(fileName.find_last_of("\\/") + 1);
+        for (int i = 0; i < configurations.size(); i++)
+        {
+            SolverOptions options = configurations.at(i).second;
+            options.cacheDirectory = "";
+            CoverageAnalyzer analyzer(fileName, 10000, options);
+            ostringstream report;
+            streambuf* console = cout.rdbuf(report.rdbuf());
+            analyzer.analyze(testOption);
+            cout.rdbuf(console);
+
+            double saved = analyzer.warmup ? max(analyzer.warmup->getWarmupTime() - analyzer.warmup->getWaitTime(), 0.0) : 0;
+            totalTimes.at(i) += analyzer.solvingTime;
+            totalCoverage.at(i) += analyzer.coverageRate;
+            totalStartup.at(i) += analyzer.startupTime;
+            totalSaved.at(i) += saved;
+            cout << left << setw(nameWidth) << shortName << setw(nameWidth) << configurations.at(i).first << right;
+            cout << fixed << setprecision(2) << setw(columnWidth - 1) << analyzer.coverageRate << "%";
+            cout << setw(columnWidth) << analyzer.solvingTime;
+            cout << setw(columnWidth) << analyzer.solverStats.queriesSent;
+            cout << setw(columnWidth) << analyzer.solverStats.queriesUnknown;
+            cout << setw(columnWidth) << analyzer.startupTime << setw(columnWidth) << saved << "\n";
+        }
+    }
+    if (fileNames.empty())
+    {
+        return;
+    }
+    cout << "\nTotals:\n";
+    for (int i = 0; i < configurations.size(); i++)
+    {
+        cout << left << setw(nameWidth) << "" << setw(nameWidth) << configurations.at(i).first << right;
+        cout << fixed << setprecision(2) << setw(columnWidth - 1) << totalCoverage.at(i) / fileNames.size() << "%";
+        cout << setw(columnWidth) << totalTimes.at(i);
+        cout << setw(columnWidth * 3) << totalStartup.at(i) << setw(columnWidth) << totalSaved.at(i) << "\n";
+    }
+    double startup = accumulate(totalStartup.begin(), totalStartup.end(), 0.0);
+    double saved = accumulate(totalSaved.begin(), totalSaved.end(), 0.0);
+    if (startup + saved > 0)
+    {
+        cout << "\nStartup latency: " << startup << " ms, " << saved << " ms (" << 100.0 * saved / (startup + saved);
+        cout << "%) less than with the Z3 context created after the front end\n";
+    }
 }
\ No newline at end of file
@@ -4,16 +4,37 @@
 #include "Parser.h"
 #include "CFG.h"
 #include "Solver.h"
+#include "ContextWarmup.h"
 #include <unordered_set>
 #include <iomanip>
+#include <chrono>
+#include <memory>
 
 class CoverageAnalyzer
 {
     CFG cfg;
-    vector<Identifier> ids;
+    Tables tables;
+    int maxIterForLoops;
+    SolverOptions options;
     vector<pair<Path, TestCase>> pathsAndCasesTable;
     unordered_set<int> visitedNodes;
     vector<pair<int, int>> visitedBranches;
+    SolverStats solverStats;
+    map<int, int> loopBounds;
+    set<int> unknownNodes;                              // Uncovered nodes the solver could not decide within the budget
+    set<int> staticDeadNodes;                           // Nodes interval analysis proved unreachable before solving
+    bool budgetExhausted;
+    double solvingTime;                                 // Milliseconds spent on finding the paths and test cases
+    double coverageRate;                                // Percentage of the nodes or edges the test suite covers
+    unique_ptr<ContextWarmup> warmup;                   // Z3 context being created while the front end runs
+    double frontEndTime;                                // Milliseconds spent on lexing, parsing and building the CFG
+    double startupTime;                                 // Milliseconds from the start until the solver is ready
+
+    // Find test cases for the coverage goal
+    void solve(coverageGoal goal);
+
+    // Report the dead code interval analysis finds before solving
+    void reportStaticDeadCode(Solver& solver);
 
     // Detect unreachable code lines
     void findDeadCodeNodes();
@@ -27,10 +48,16 @@ class CoverageAnalyzer
     // Print table of coverage analysis results
     void printTable(vector<TestCase> testSuite);
 
+    // Print solver counters
+    void printSolverStats();
+
 public:
-    CoverageAnalyzer(string fileName, int maxIterForLoops = 10000);
+    CoverageAnalyzer(string fileName, int maxIterForLoops = 10000, SolverOptions options = SolverOptions());
 
     void analyze(int testOption);
+
+    // Run the coverage test of every file under every named set of options and print a comparison table
+    static void benchmark(const vector<string>& fileNames, const vector<pair<string, SolverOptions>>& configurations, int testOption);
 };
 
 #endif
\ No newline at end of file
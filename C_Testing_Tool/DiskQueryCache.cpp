@@ -0,0 +1,187 @@
+#include "DiskQueryCache.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define makeDirectory(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define makeDirectory(path) mkdir(path, 0755)
+#endif
+
+// Constructor. An empty directory disables the cache
+DiskQueryCache::DiskQueryCache(std::string directory) : directory(directory)
+{
+    logSize = 0;
+    if (isEnabled())
+    {
+        makeDirectory(directory.c_str());
+        loadIndex();
+    }
+}
+
+bool DiskQueryCache::isEnabled() const
+{
+    return !directory.empty();
+}
+
+// FNV-1a hash, stable across runs and platforms
+uint64_t DiskQueryCache::hash(const std::string& text)
+{
+    uint64_t result = 14695981039346656037ULL;
+    for (unsigned char c : text)
+    {
+        result ^= c;
+        result *= 1099511628211ULL;
+    }
+    return result;
+}
+
+// Read offsets of the logged records
+void DiskQueryCache::loadIndex()
+{
+    std::ifstream log(directory + "/" + QUERY_LOG_FILE, std::ios::binary | std::ios::ate);
+    if (log)
+    {
+        logSize = log.tellg();
+    }
+    std::ifstream indexFile(directory + "/" + QUERY_INDEX_FILE);
+    uint64_t key;
+    long long offset;
+    while (indexFile >> key >> offset)
+    {
+        if (offset < logSize)                           // skip entries of a record that was not written completely
+        {
+            index.emplace(key, offset);
+        }
+    }
+}
+
+// Print the query as SMT-LIB2 script with the declarations and the constraints in a canonical order
+// and collect declarations of its constants
+std::string DiskQueryCache::toSmtLib(const std::vector<expr>& query, func_decl_vector& decls)
+{
+    std::set<std::string> constraints;
+    std::map<std::string, func_decl> declsByName;
+    std::vector<expr> stack;
+    std::set<unsigned> visited;
+    for (auto& constraint : query)
+    {
+        constraints.insert(constraint.to_string());
+        stack.push_back(constraint);
+    }
+    while (!stack.empty())
+    {
+        expr curr = stack.back();
+        stack.pop_back();
+        if (!curr.is_app() || !visited.insert(curr.id()).second)
+        {
+            continue;
+        }
+        if (curr.is_const() && curr.decl().decl_kind() == Z3_OP_UNINTERPRETED)
+        {
+            declsByName.emplace(curr.decl().name().str(), curr.decl());
+        }
+        for (int i = 0; i < curr.num_args(); i++)
+        {
+            stack.push_back(curr.arg(i));
+        }
+    }
+
+    std::string text;
+    for (auto& decl : declsByName)
+    {
+        decls.push_back(decl.second);
+        text += decl.second.to_string() + "\n";
+    }
+    for (auto& constraint : constraints)
+    {
+        text += "(assert " + constraint + ")\n";
+    }
+    return text + "(check-sat)\n";
+}
+
+// Find result of the query in the log. Returns unknown on a miss
+check_result DiskQueryCache::lookup(const std::vector<expr>& query, model& m)
+{
+    if (!isEnabled() || query.empty())
+    {
+        return unknown;
+    }
+    context& ctx = query.front().ctx();
+    func_decl_vector decls(ctx);
+    std::string queryText = toSmtLib(query, decls);
+    auto range = index.equal_range(hash(queryText));
+    for (auto it = range.first; it != range.second; it++)
+    {
+        std::ifstream log(directory + "/" + QUERY_LOG_FILE, std::ios::binary);
+        log.seekg(it->second);
+        int result;
+        size_t queryLength;
+        size_t modelLength;
+        if (!(log >> result >> queryLength >> modelLength) || queryLength != queryText.size())
+        {
+            continue;
+        }
+        log.get();                                      // end of the header line
+        std::string storedQuery(queryLength, '\0');
+        std::string modelText(modelLength, '\0');
+        log.read(&storedQuery[0], queryLength);
+        log.read(&modelText[0], modelLength);
+        if (!log || storedQuery != queryText)           // hash collision
+        {
+            continue;
+        }
+
+        if (result == sat)
+        {
+            sort_vector sorts(ctx);
+            expr_vector assignments = ctx.parse_string(modelText.c_str(), sorts, decls);
+            model stored(ctx);
+            for (int i = 0; i < assignments.size(); i++)
+            {
+                func_decl decl = assignments[i].arg(0).decl();
+                expr value = assignments[i].arg(1);
+                stored.add_const_interp(decl, value);
+            }
+            m = stored;
+        }
+        return (check_result) result;
+    }
+    return unknown;
+}
+
+// Append result of a query answered by the solver to the log
+void DiskQueryCache::insert(const std::vector<expr>& query, check_result result, const model& m)
+{
+    if (!isEnabled() || query.empty() || result == unknown)
+    {
+        return;
+    }
+    func_decl_vector decls(query.front().ctx());
+    std::string queryText = toSmtLib(query, decls);
+    std::string modelText;
+    if (result == sat)
+    {
+        for (int i = 0; i < decls.size(); i++)
+        {
+            expr var = decls[i]();
+            modelText += "(assert " + (var == m.eval(var, true)).to_string() + ")\n";
+        }
+    }
+
+    std::stringstream record;
+    record << (int) result << " " << queryText.size() << " " << modelText.size() << "\n" << queryText << modelText;
+    std::string recordText = record.str();
+    std::ofstream log(directory + "/" + QUERY_LOG_FILE, std::ios::binary | std::ios::app);
+    log << recordText;
+    log.close();
+    if (!log)
+    {
+        return;
+    }
+    std::ofstream indexFile(directory + "/" + QUERY_INDEX_FILE, std::ios::app);
+    uint64_t key = hash(queryText);
+    indexFile << key << " " << logSize << "\n";
+    index.emplace(key, logSize);
+    logSize += recordText.size();
+}
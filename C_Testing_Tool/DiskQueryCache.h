@@ -0,0 +1,44 @@
+#ifndef DISKQUERYCACHE_H
+#define DISKQUERYCACHE_H
+
+#define QUERY_LOG_FILE "queries.log"
+#define QUERY_INDEX_FILE "queries.idx"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <set>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <z3++.h>
+
+using namespace z3;
+
+// Results and models of solver queries kept on disk between runs.
+// Every query is printed as canonical SMT-LIB2 text and found by its hash.
+// The directory holds an append-only log of records and an index of their offsets:
+//   log record: "<result> <query length> <model length>\n<query><model>"
+//   index line: "<hash> <offset>"
+class DiskQueryCache
+{
+    std::string directory;
+    std::unordered_multimap<uint64_t, long long> index;  // Log offsets by query hash
+    long long logSize;
+
+    static uint64_t hash(const std::string& text);
+    std::string toSmtLib(const std::vector<expr>& query, func_decl_vector& decls);
+    void loadIndex();
+
+public:
+    DiskQueryCache(std::string directory = "");
+
+    bool isEnabled() const;
+
+    check_result lookup(const std::vector<expr>& query, model& m);
+    void insert(const std::vector<expr>& query, check_result result, const model& m);
+};
+
+#endif
@@ -0,0 +1,647 @@
+#include "IntervalAnalysis.h"
+
+#define INTERVAL_LIMIT (INT64_C(1) << 61)               // Larger finite bounds are taken as unbounded
+
+using Interval = IntervalAnalysis::Interval;
+
+// Sum of bounds. An unbounded side stays unbounded
+int64_t addBounds(int64_t a, int64_t b)
+{
+    if (a == INTERVAL_INF || a == -INTERVAL_INF)
+    {
+        return a;
+    }
+    if (b == INTERVAL_INF || b == -INTERVAL_INF)
+    {
+        return b;
+    }
+    int64_t sum = a + b;
+    return sum > INTERVAL_LIMIT ? INTERVAL_INF : sum < -INTERVAL_LIMIT ? -INTERVAL_INF : sum;
+}
+
+// Product of bounds
+int64_t multiplyBounds(int64_t a, int64_t b)
+{
+    if (a == 0 || b == 0)
+    {
+        return 0;
+    }
+    bool negative = (a < 0) != (b < 0);
+    if (a == INTERVAL_INF || a == -INTERVAL_INF || b == INTERVAL_INF || b == -INTERVAL_INF ||
+        (a < 0 ? -a : a) > INTERVAL_LIMIT / (b < 0 ? -b : b))
+    {
+        return negative ? -INTERVAL_INF : INTERVAL_INF;
+    }
+    return a * b;
+}
+
+// Quotient of a bound by a nonzero number, rounded down or up
+int64_t divideBound(int64_t a, int64_t divisor, bool roundUp)
+{
+    if (a == INTERVAL_INF || a == -INTERVAL_INF)
+    {
+        return (a < 0) != (divisor < 0) ? -INTERVAL_INF : INTERVAL_INF;
+    }
+    int64_t quotient = a / divisor;
+    bool inexact = a % divisor != 0;
+    bool positive = (a < 0) == (divisor < 0);
+    if (inexact && roundUp && positive)
+    {
+        quotient++;
+    }
+    else if (inexact && !roundUp && !positive)
+    {
+        quotient--;
+    }
+    return quotient;
+}
+
+Interval makeInterval(int64_t low, int64_t high)
+{
+    Interval interval;
+    interval.low = low;
+    interval.high = high;
+    return interval;
+}
+
+Interval unbounded()
+{
+    return makeInterval(-INTERVAL_INF, INTERVAL_INF);
+}
+
+bool isEmpty(const Interval& interval)
+{
+    return interval.low > interval.high;
+}
+
+Interval intersect(const Interval& a, const Interval& b)
+{
+    return makeInterval(std::max(a.low, b.low), std::min(a.high, b.high));
+}
+
+Interval negate(const Interval& a)
+{
+    return makeInterval(-a.high, -a.low);
+}
+
+Interval add(const Interval& a, const Interval& b)
+{
+    return makeInterval(addBounds(a.low, b.low), addBounds(a.high, b.high));
+}
+
+Interval multiply(const Interval& a, const Interval& b)
+{
+    int64_t corners[4] = {
+        multiplyBounds(a.low, b.low), multiplyBounds(a.low, b.high),
+        multiplyBounds(a.high, b.low), multiplyBounds(a.high, b.high)
+    };
+    return makeInterval(*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4));
+}
+
+// Values x with x * factor in the interval, for a nonzero factor
+Interval divideExact(const Interval& a, int64_t factor)
+{
+    return factor > 0 ?
+        makeInterval(divideBound(a.low, factor, true), divideBound(a.high, factor, false)) :
+        makeInterval(divideBound(a.high, factor, true), divideBound(a.low, factor, false));
+}
+
+// Comparison that holds exactly when the given one does not
+Z3_decl_kind negateComparison(Z3_decl_kind kind)
+{
+    switch (kind)
+    {
+    case Z3_OP_LE:
+        return Z3_OP_GT;
+
+    case Z3_OP_GE:
+        return Z3_OP_LT;
+
+    case Z3_OP_LT:
+        return Z3_OP_GE;
+
+    case Z3_OP_GT:
+        return Z3_OP_LE;
+
+    case Z3_OP_EQ:
+        return Z3_OP_DISTINCT;
+
+    default:
+        return Z3_OP_EQ;
+    }
+}
+
+
+//.........................INTERVAL ANALYSIS
+
+// Constructor. Variable i of the states is the placeholder i
+IntervalAnalysis::IntervalAnalysis(const expr_vector& placeholders)
+{
+    varCount = placeholders.size();
+    for (int i = 0; i < varCount; i++)
+    {
+        positions[placeholders[i].id()] = i;
+    }
+    converged = false;
+}
+
+// Add node with its code on a forward and on a back edge
+void IntervalAnalysis::addNode(int nodeId, const std::vector<std::pair<int, expr>>& entryUpdates, const std::vector<std::pair<int, expr>>& backUpdates)
+{
+    AbstractNode& node = nodes[nodeId];
+    node.entryUpdates = entryUpdates;
+    node.backUpdates = backUpdates;
+}
+
+// Add edge taken when the condition holds. The updates are the writes of the condition
+void IntervalAnalysis::addEdge(int nodeId, int target, const expr& condition, const std::vector<std::pair<int, expr>>& updates)
+{
+    AbstractEdge edge{ target, condition, updates };
+    nodes.emplace(target, AbstractNode());              // the target may be added later or not at all
+    predecessors[target].push_back(std::make_pair(nodeId, (int) nodes[nodeId].edges.size()));
+    nodes[nodeId].edges.push_back(edge);
+}
+
+// State of any values
+IntervalAnalysis::State IntervalAnalysis::top() const
+{
+    return State{ true, std::vector<Interval>(varCount, unbounded()) };
+}
+
+// State of no execution
+IntervalAnalysis::State IntervalAnalysis::bottom() const
+{
+    return State{ false, std::vector<Interval>(varCount, unbounded()) };
+}
+
+// Interval of the values of an integer expression. Other sorts and unknown operators are unbounded
+Interval IntervalAnalysis::evaluate(const expr& e, const State& state)
+{
+    if (!e.is_app() || !e.is_int())
+    {
+        return unbounded();
+    }
+    int64_t value;
+    if (e.is_numeral())
+    {
+        bool fits = e.is_numeral_i64(value) && value <= INTERVAL_LIMIT && value >= -INTERVAL_LIMIT;
+        return fits ? makeInterval(value, value) : unbounded();
+    }
+    auto it = positions.find(e.id());
+    if (it != positions.end())
+    {
+        return state.values.at(it->second);
+    }
+
+    Interval result = unbounded();
+    switch (e.decl().decl_kind())
+    {
+    case Z3_OP_ADD:
+        result = makeInterval(0, 0);
+        for (int i = 0; i < e.num_args(); i++)
+        {
+            result = add(result, evaluate(e.arg(i), state));
+        }
+        return result;
+
+    case Z3_OP_SUB:
+        result = evaluate(e.arg(0), state);
+        for (int i = 1; i < e.num_args(); i++)
+        {
+            result = add(result, negate(evaluate(e.arg(i), state)));
+        }
+        return result;
+
+    case Z3_OP_UMINUS:
+        return negate(evaluate(e.arg(0), state));
+
+    case Z3_OP_MUL:
+        result = makeInterval(1, 1);
+        for (int i = 0; i < e.num_args(); i++)
+        {
+            result = multiply(result, evaluate(e.arg(i), state));
+        }
+        return result;
+
+    case Z3_OP_IDIV:
+    {
+        Interval a = evaluate(e.arg(0), state);
+        Interval b = evaluate(e.arg(1), state);
+        int64_t bounds[4] = { a.low, a.high, b.low, b.high };
+        for (auto& bound : bounds)
+        {
+            if (bound == INTERVAL_INF || bound == -INTERVAL_INF)
+            {
+                return unbounded();
+            }
+        }
+        if (b.low <= 0 && b.high >= 0)
+        {
+            return unbounded();
+        }
+        int64_t low = INTERVAL_INF;
+        int64_t high = -INTERVAL_INF;
+        for (int i = 0; i < 2; i++)
+        {
+            for (int j = 2; j < 4; j++)
+            {
+                low = std::min(low, divideBound(bounds[i], bounds[j], false));
+                high = std::max(high, divideBound(bounds[i], bounds[j], true));
+            }
+        }
+        return makeInterval(low, high);
+    }
+
+    case Z3_OP_MOD: case Z3_OP_REM:
+    {
+        // The remainder is smaller than the divisor in magnitude; mod is never negative
+        Interval b = evaluate(e.arg(1), state);
+        if (b.low <= 0 && b.high >= 0)
+        {
+            return unbounded();
+        }
+        int64_t magnitude = std::max(b.high, -b.low);
+        int64_t high = magnitude == INTERVAL_INF ? INTERVAL_INF : std::max(magnitude - 1, (int64_t) 0);
+        return makeInterval(e.decl().decl_kind() == Z3_OP_MOD ? 0 : -high, high);
+    }
+
+    case Z3_OP_ITE:
+    {
+        State thenState = state;
+        State elseState = state;
+        bool thenTaken = assume(e.arg(0), true, thenState);
+        bool elseTaken = assume(e.arg(0), false, elseState);
+        if (thenTaken && elseTaken)
+        {
+            Interval a = evaluate(e.arg(1), thenState);
+            Interval b = evaluate(e.arg(2), elseState);
+            return makeInterval(std::min(a.low, b.low), std::max(a.high, b.high));
+        }
+        if (thenTaken || elseTaken)
+        {
+            return thenTaken ? evaluate(e.arg(1), thenState) : evaluate(e.arg(2), elseState);
+        }
+        return result;
+    }
+
+    default:
+        return result;
+    }
+}
+
+// Narrow the variables of an integer expression to the values that keep it in the target.
+// Returns false if no values do
+bool IntervalAnalysis::refine(const expr& e, Interval target, State& state)
+{
+    Interval current = intersect(evaluate(e, state), target);
+    if (isEmpty(current))
+    {
+        return false;
+    }
+    if (!e.is_app() || !e.is_int() || e.is_numeral())
+    {
+        return true;
+    }
+    auto it = positions.find(e.id());
+    if (it != positions.end())
+    {
+        state.values.at(it->second) = current;
+        return true;
+    }
+
+    switch (e.decl().decl_kind())
+    {
+    case Z3_OP_ADD:
+        for (int i = 0; i < e.num_args(); i++)
+        {
+            Interval rest = makeInterval(0, 0);
+            for (int j = 0; j < e.num_args(); j++)
+            {
+                rest = j == i ? rest : add(rest, evaluate(e.arg(j), state));
+            }
+            if (!refine(e.arg(i), add(current, negate(rest)), state))
+            {
+                return false;
+            }
+        }
+        return true;
+
+    case Z3_OP_SUB:
+        if (e.num_args() == 2)
+        {
+            Interval a = evaluate(e.arg(0), state);
+            Interval b = evaluate(e.arg(1), state);
+            return refine(e.arg(0), add(current, b), state) && refine(e.arg(1), add(a, negate(current)), state);
+        }
+        return true;
+
+    case Z3_OP_UMINUS:
+        return refine(e.arg(0), negate(current), state);
+
+    case Z3_OP_MUL:
+    {
+        int64_t factor;
+        if (e.num_args() == 2 && e.arg(0).is_numeral_i64(factor) && factor != 0)
+        {
+            return refine(e.arg(1), divideExact(current, factor), state);
+        }
+        if (e.num_args() == 2 && e.arg(1).is_numeral_i64(factor) && factor != 0)
+        {
+            return refine(e.arg(0), divideExact(current, factor), state);
+        }
+        return true;
+    }
+
+    default:
+        return true;
+    }
+}
+
+// Narrow the state to the executions where the comparison holds. Returns false if there are none
+bool IntervalAnalysis::assumeComparison(Z3_decl_kind kind, const expr& a, const expr& b, State& state)
+{
+    if (!a.is_int() || !b.is_int())
+    {
+        return true;
+    }
+    Interval intervalA = evaluate(a, state);
+    Interval intervalB = evaluate(b, state);
+    switch (kind)
+    {
+    case Z3_OP_LE:
+        return refine(a, makeInterval(-INTERVAL_INF, intervalB.high), state) &&
+            refine(b, makeInterval(intervalA.low, INTERVAL_INF), state);
+
+    case Z3_OP_LT:
+        return refine(a, makeInterval(-INTERVAL_INF, addBounds(intervalB.high, -1)), state) &&
+            refine(b, makeInterval(addBounds(intervalA.low, 1), INTERVAL_INF), state);
+
+    case Z3_OP_GE:
+        return assumeComparison(Z3_OP_LE, b, a, state);
+
+    case Z3_OP_GT:
+        return assumeComparison(Z3_OP_LT, b, a, state);
+
+    case Z3_OP_EQ:
+    {
+        Interval common = intersect(intervalA, intervalB);
+        return !isEmpty(common) && refine(a, common, state) && refine(b, common, state);
+    }
+
+    default:
+    {
+        // Disequality cuts a bound equal to a constant on the other side
+        if (intervalA.low == intervalA.high && intervalB.low == intervalB.high)
+        {
+            return intervalA.low != intervalB.low;
+        }
+        if (intervalB.low == intervalB.high && (intervalA.low == intervalB.low || intervalA.high == intervalB.low))
+        {
+            Interval rest = intervalA.low == intervalB.low ?
+                makeInterval(addBounds(intervalA.low, 1), intervalA.high) :
+                makeInterval(intervalA.low, addBounds(intervalA.high, -1));
+            return refine(a, rest, state);
+        }
+        if (intervalA.low == intervalA.high && (intervalB.low == intervalA.low || intervalB.high == intervalA.low))
+        {
+            return assumeComparison(Z3_OP_DISTINCT, b, a, state);
+        }
+        return true;
+    }
+    }
+}
+
+// Narrow the state to the executions where the condition has the given value. Returns false if there are none
+bool IntervalAnalysis::assume(const expr& condition, bool positive, State& state)
+{
+    if (condition.is_true() || condition.is_false())
+    {
+        return condition.is_true() == positive;
+    }
+    if (!condition.is_app())
+    {
+        return true;
+    }
+    Z3_decl_kind kind = condition.decl().decl_kind();
+    switch (kind)
+    {
+    case Z3_OP_NOT:
+        return assume(condition.arg(0), !positive, state);
+
+    case Z3_OP_AND: case Z3_OP_OR:
+    {
+        if ((kind == Z3_OP_AND) == positive)
+        {
+            for (int i = 0; i < condition.num_args(); i++)
+            {
+                if (!assume(condition.arg(i), positive, state))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Disjunction: join the states of its parts
+        State joined = bottom();
+        for (int i = 0; i < condition.num_args(); i++)
+        {
+            State part = state;
+            if (assume(condition.arg(i), positive, part))
+            {
+                joined = join(joined, part);
+            }
+        }
+        state = joined;
+        return joined.reachable;
+    }
+
+    case Z3_OP_LE: case Z3_OP_GE: case Z3_OP_LT: case Z3_OP_GT: case Z3_OP_EQ: case Z3_OP_DISTINCT:
+    {
+        if (condition.num_args() != 2)
+        {
+            return true;
+        }
+        return assumeComparison(positive ? kind : negateComparison(kind), condition.arg(0), condition.arg(1), state);
+    }
+
+    default:
+        return true;
+    }
+}
+
+// Execute updates on the state. All of them read the state as it was before
+IntervalAnalysis::State IntervalAnalysis::apply(const std::vector<std::pair<int, expr>>& updates, const State& state)
+{
+    if (!state.reachable)
+    {
+        return state;
+    }
+    State result = state;
+    for (auto& update : updates)
+    {
+        result.values.at(update.first) = evaluate(update.second, state);
+    }
+    return result;
+}
+
+IntervalAnalysis::State IntervalAnalysis::join(const State& a, const State& b)
+{
+    if (!a.reachable || !b.reachable)
+    {
+        return a.reachable ? a : b;
+    }
+    State result = a;
+    for (int i = 0; i < varCount; i++)
+    {
+        result.values.at(i).low = std::min(a.values.at(i).low, b.values.at(i).low);
+        result.values.at(i).high = std::max(a.values.at(i).high, b.values.at(i).high);
+    }
+    return result;
+}
+
+// Widen the old state by the new one: a bound that grew is dropped
+IntervalAnalysis::State IntervalAnalysis::widen(const State& a, const State& b)
+{
+    if (!a.reachable || !b.reachable)
+    {
+        return a.reachable ? a : b;
+    }
+    State result = a;
+    for (int i = 0; i < varCount; i++)
+    {
+        if (b.values.at(i).low < a.values.at(i).low)
+        {
+            result.values.at(i).low = -INTERVAL_INF;
+        }
+        if (b.values.at(i).high > a.values.at(i).high)
+        {
+            result.values.at(i).high = INTERVAL_INF;
+        }
+    }
+    return result;
+}
+
+// State passed along the edge
+IntervalAnalysis::State IntervalAnalysis::followEdge(int nodeId, int edgeIndex)
+{
+    State state = states.at(nodeId);
+    const AbstractEdge& edge = nodes.at(nodeId).edges.at(edgeIndex);
+    if (!state.reachable || !assume(edge.condition, true, state))
+    {
+        return bottom();
+    }
+    return apply(edge.updates, state);
+}
+
+// Order nodes reachable from the entry in reverse postorder and find the back edges
+std::vector<int> IntervalAnalysis::orderNodes(int entryId)
+{
+    std::vector<int> postorder;
+    std::set<int> visited{ entryId };
+    std::set<int> onStack{ entryId };
+    std::vector<std::pair<int, int>> stack{ std::make_pair(entryId, 0) };   // Node and its next edge
+    while (!stack.empty())
+    {
+        int nodeId = stack.back().first;
+        int edgeIndex = stack.back().second++;
+        const std::vector<AbstractEdge>& edges = nodes[nodeId].edges;
+        if (edgeIndex >= edges.size())
+        {
+            postorder.push_back(nodeId);
+            onStack.erase(nodeId);
+            stack.pop_back();
+            continue;
+        }
+        int target = edges.at(edgeIndex).target;
+        if (onStack.count(target))
+        {
+            backEdges.insert(std::make_pair(nodeId, edgeIndex));
+        }
+        else if (visited.insert(target).second)
+        {
+            onStack.insert(target);
+            stack.push_back(std::make_pair(target, 0));
+        }
+    }
+    return std::vector<int>(postorder.rbegin(), postorder.rend());
+}
+
+// Recompute the state of the node from its predecessors. Returns true if it changed
+bool IntervalAnalysis::update(int nodeId, int entryId, bool widening)
+{
+    State forward = nodeId == entryId ? top() : bottom();
+    State back = bottom();
+    bool isLoopHead = false;
+    for (auto& predecessor : predecessors[nodeId])
+    {
+        State incoming = followEdge(predecessor.first, predecessor.second);
+        if (backEdges.count(predecessor))
+        {
+            isLoopHead = true;
+            back = join(back, incoming);
+        }
+        else
+        {
+            forward = join(forward, incoming);
+        }
+    }
+    const AbstractNode& node = nodes.at(nodeId);
+    State result = join(apply(node.entryUpdates, forward), apply(node.backUpdates, back));
+    State& old = states.at(nodeId);
+    if (widening && isLoopHead)
+    {
+        result = widen(old, join(old, result));
+    }
+    bool changed = result.reachable != old.reachable;
+    for (int i = 0; i < varCount && !changed && result.reachable; i++)
+    {
+        changed = result.values.at(i).low != old.values.at(i).low || result.values.at(i).high != old.values.at(i).high;
+    }
+    old = result;
+    return changed;
+}
+
+// Compute the states up to a fixpoint, widening at loop heads, and narrow them
+void IntervalAnalysis::run(int entryId)
+{
+    backEdges.clear();
+    states.clear();
+    for (auto& entry : nodes)
+    {
+        states.emplace(entry.first, bottom());
+    }
+    std::vector<int> order = orderNodes(entryId);
+    bool changed = true;
+    for (int round = 0; round < INTERVAL_MAX_ROUNDS && changed; round++)
+    {
+        changed = false;
+        for (auto& nodeId : order)
+        {
+            changed = update(nodeId, entryId, true) || changed;
+        }
+    }
+    converged = !changed;
+
+    // Every pass without widening from a fixpoint keeps the states sound
+    for (int round = 0; round < INTERVAL_NARROWING_ROUNDS && converged; round++)
+    {
+        for (auto& nodeId : order)
+        {
+            update(nodeId, entryId, false);
+        }
+    }
+}
+
+// Check whether some execution may reach the node
+bool IntervalAnalysis::isReachable(int nodeId) const
+{
+    auto it = states.find(nodeId);
+    return !converged || it == states.end() || it->second.reachable;
+}
+
+// Check whether some execution may take the edge
+bool IntervalAnalysis::isFeasible(int nodeId, int edgeIndex)
+{
+    return !converged || !states.count(nodeId) || followEdge(nodeId, edgeIndex).reachable;
+}
@@ -0,0 +1,84 @@
+#ifndef INTERVALANALYSIS_H
+#define INTERVALANALYSIS_H
+
+#define INTERVAL_INF INT64_MAX                          // Bound of an interval unbounded on that side
+#define INTERVAL_MAX_ROUNDS 1000                        // Passes over the graph before the analysis gives up
+#define INTERVAL_NARROWING_ROUNDS 2                     // Passes without widening after the fixpoint
+
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <cstdint>
+#include <z3++.h>
+
+using namespace z3;
+
+// Forward abstract interpretation over a control flow graph with one interval per integer variable.
+// Every node holds the interval state after executing its code. A node reached by a back edge of
+// a loop may run different code than on entering the loop, like the iteration step of a for loop.
+// States are widened at the targets of back edges and then narrowed by a few more passes.
+// A node whose state stays empty is unreachable, and so is an edge whose condition empties
+// the state of its source
+class IntervalAnalysis
+{
+public:
+    struct Interval
+    {
+        int64_t low, high;                              // -INTERVAL_INF and INTERVAL_INF for no bound
+    };
+
+private:
+    struct State
+    {
+        bool reachable;
+        std::vector<Interval> values;                   // Interval of every variable by its position
+    };
+
+    struct AbstractEdge
+    {
+        int target;
+        expr condition;
+        std::vector<std::pair<int, expr>> updates;      // Variables the condition writes, by position
+    };
+
+    struct AbstractNode
+    {
+        std::vector<std::pair<int, expr>> entryUpdates; // Code on entering the node along a forward edge
+        std::vector<std::pair<int, expr>> backUpdates;  // Code on entering the node along a back edge
+        std::vector<AbstractEdge> edges;
+    };
+
+    std::map<unsigned, int> positions;                  // Position of a variable by the AST ID of its placeholder
+    int varCount;
+    std::map<int, AbstractNode> nodes;
+    std::map<int, std::vector<std::pair<int, int>>> predecessors;   // Source node and edge index
+    std::set<std::pair<int, int>> backEdges;            // Source node and edge index
+    std::map<int, State> states;
+    bool converged;
+
+    State top() const;
+    State bottom() const;
+    Interval evaluate(const expr& e, const State& state);
+    bool refine(const expr& e, Interval target, State& state);
+    bool assume(const expr& condition, bool positive, State& state);
+    bool assumeComparison(Z3_decl_kind kind, const expr& a, const expr& b, State& state);
+    State apply(const std::vector<std::pair<int, expr>>& updates, const State& state);
+    State join(const State& a, const State& b);
+    State widen(const State& a, const State& b);
+    State followEdge(int nodeId, int edgeIndex);
+    std::vector<int> orderNodes(int entryId);
+    bool update(int nodeId, int entryId, bool widening);
+
+public:
+    IntervalAnalysis(const expr_vector& placeholders);
+
+    void addNode(int nodeId, const std::vector<std::pair<int, expr>>& entryUpdates, const std::vector<std::pair<int, expr>>& backUpdates);
+    void addEdge(int nodeId, int target, const expr& condition, const std::vector<std::pair<int, expr>>& updates);
+    void run(int entryId);
+
+    bool isReachable(int nodeId) const;
+    bool isFeasible(int nodeId, int edgeIndex);
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "PathCondition.h"
+
+// Constructor
+PathCondition::PathCondition(int varCount)
+{
+    checkedCount = 0;
+    parent = std::vector<int>(varCount);
+    std::iota(parent.begin(), parent.end(), 0);
+    clusterSizes = std::vector<int>(varCount, 1);
+}
+
+// Get number of constraints
+int PathCondition::getSize() const
+{
+    return constraints.size();
+}
+
+// Get constraint by index
+expr PathCondition::get(int index) const
+{
+    return constraints.at(index);
+}
+
+// Get identifier IDs of the variables the constraint reads
+const std::vector<int>& PathCondition::getVars(int index) const
+{
+    return constraintVars.at(index);
+}
+
+// Get branch edge of the path that added the constraint
+std::pair<int, int> PathCondition::getDecision(int index) const
+{
+    return decisions.at(index);
+}
+
+// Add constraint over the given variables
+void PathCondition::add(const expr& constraint, const std::vector<int>& vars, std::pair<int, int> decision)
+{
+    unionCounts.push_back(unions.size());
+    for (int i = 1; i < vars.size(); i++)
+    {
+        unite(vars.front(), vars.at(i));
+    }
+    constraints.push_back(constraint);
+    constraintVars.push_back(vars);
+    decisions.push_back(decision);
+}
+
+// Drop constraints added after the path condition had the given size
+void PathCondition::truncate(int size)
+{
+    if (size < constraints.size())
+    {
+        while (unions.size() > unionCounts.at(size))
+        {
+            int root = unions.back();
+            clusterSizes.at(parent.at(root)) -= clusterSizes.at(root);
+            parent.at(root) = root;
+            unions.pop_back();
+        }
+        unionCounts.erase(unionCounts.begin() + size, unionCounts.end());
+        constraints.erase(constraints.begin() + size, constraints.end());
+        constraintVars.erase(constraintVars.begin() + size, constraintVars.end());
+        decisions.erase(decisions.begin() + size, decisions.end());
+    }
+    checkedCount = std::min(checkedCount, size);
+}
+
+int PathCondition::getCheckedCount() const
+{
+    return checkedCount;
+}
+
+void PathCondition::setCheckedCount(int count)
+{
+    checkedCount = count;
+}
+
+// Find representative of the variable's cluster. The trees stay shallow by union by size
+int PathCondition::find(int varId) const
+{
+    while (parent.at(varId) != varId)
+    {
+        varId = parent.at(varId);
+    }
+    return varId;
+}
+
+// Merge clusters of two variables, attaching the smaller tree to the larger one
+void PathCondition::unite(int varId1, int varId2)
+{
+    int root1 = find(varId1);
+    int root2 = find(varId2);
+    if (root1 == root2)
+    {
+        return;
+    }
+    if (clusterSizes.at(root1) > clusterSizes.at(root2))
+    {
+        std::swap(root1, root2);
+    }
+    parent.at(root1) = root2;
+    clusterSizes.at(root2) += clusterSizes.at(root1);
+    unions.push_back(root1);
+}
+
+// Get cluster root of every constraint.
+// A constraint without variables is a cluster of its own, marked with -1 - index
+std::vector<int> PathCondition::getClusterRoots() const
+{
+    std::vector<int> roots;
+    for (int i = 0; i < constraintVars.size(); i++)
+    {
+        roots.push_back(constraintVars.at(i).empty() ? -1 - i : find(constraintVars.at(i).front()));
+    }
+    return roots;
+}
+
+// Get indices of constraints in every independent cluster
+std::vector<std::vector<int>> PathCondition::getClusters()
+{
+    std::vector<int> roots = getClusterRoots();
+    std::vector<std::vector<int>> clusters;
+    std::map<int, int> clusterIndices;                  // Index in clusters by root
+    for (int i = 0; i < roots.size(); i++)
+    {
+        auto it = clusterIndices.emplace(roots.at(i), clusters.size()).first;
+        if (it->second == clusters.size())
+        {
+            clusters.push_back({});
+        }
+        clusters.at(it->second).push_back(i);
+    }
+    return clusters;
+}
+
+// Get indices of constraints in the clusters of the constraints not checked yet
+std::vector<int> PathCondition::getPendingSlice()
+{
+    std::vector<int> slice;
+    if (checkedCount < constraints.size())
+    {
+        std::vector<int> roots = getClusterRoots();
+        std::unordered_set<int> pendingRoots(roots.begin() + checkedCount, roots.end());
+        for (int i = 0; i < roots.size(); i++)
+        {
+            if (pendingRoots.count(roots.at(i)))
+            {
+                slice.push_back(i);
+            }
+        }
+    }
+    return slice;
+}
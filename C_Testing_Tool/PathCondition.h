@@ -0,0 +1,50 @@
+#ifndef PATHCONDITION_H
+#define PATHCONDITION_H
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <map>
+#include <unordered_set>
+#include <z3++.h>
+
+using namespace z3;
+
+// Constraints of the current path with the identifier IDs of the variables each one reads.
+// Constraints that share no variables, directly or through other constraints, are independent:
+// they form separate clusters that can be solved one by one. The clusters are kept up to date as
+// constraints are added, and unions made by dropped constraints are undone
+class PathCondition
+{
+    std::vector<expr> constraints;
+    std::vector<std::vector<int>> constraintVars;
+    std::vector<std::pair<int, int>> decisions;         // Branch edge that added each constraint, or (-1, -1)
+    int checkedCount;                                   // Constraints already sent to the solver
+    std::vector<int> parent;                            // Union-find forest over identifier IDs, without path compression
+    std::vector<int> clusterSizes;                      // Number of variables under every root
+    std::vector<int> unions;                            // Roots attached to another root, in the order of the unions
+    std::vector<int> unionCounts;                       // Number of unions before every constraint was added
+
+    int find(int varId) const;
+    void unite(int varId1, int varId2);
+    std::vector<int> getClusterRoots() const;
+
+public:
+    PathCondition(int varCount = 0);
+
+    int getSize() const;
+    expr get(int index) const;
+    const std::vector<int>& getVars(int index) const;
+    std::pair<int, int> getDecision(int index) const;
+
+    void add(const expr& constraint, const std::vector<int>& vars, std::pair<int, int> decision = std::make_pair(-1, -1));
+    void truncate(int size);
+
+    int getCheckedCount() const;
+    void setCheckedCount(int count);
+
+    std::vector<std::vector<int>> getClusters();
+    std::vector<int> getPendingSlice();
+};
+
+#endif
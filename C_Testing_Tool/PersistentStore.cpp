@@ -0,0 +1,94 @@
+#include "PersistentStore.h"
+
+// Constructor for empty store
+PersistentStore::PersistentStore()
+{
+    size = 0;
+    depth = 0;
+}
+
+// Constructor
+PersistentStore::PersistentStore(const std::vector<expr>& values)
+{
+    size = values.size();
+    depth = 0;
+    int capacity = STORE_BRANCHING;
+    while (capacity < size)
+    {
+        capacity *= STORE_BRANCHING;
+        depth++;
+    }
+    root = size > 0 ? build(values, 0, depth) : nullptr;
+}
+
+// Build subtree holding the values starting from the given index
+std::shared_ptr<PersistentStore::StoreNode> PersistentStore::build(const std::vector<expr>& values, int first, int level)
+{
+    auto node = std::make_shared<StoreNode>();
+    if (level == 0)
+    {
+        for (int i = first; i < values.size() && i < first + STORE_BRANCHING; i++)
+        {
+            node->values.push_back(values.at(i));
+        }
+        return node;
+    }
+
+    int span = 1;                                       // Number of values under each child
+    for (int i = 0; i < level; i++)
+    {
+        span *= STORE_BRANCHING;
+    }
+    for (int i = first; i < values.size() && i < first + span * STORE_BRANCHING; i += span)
+    {
+        node->children.push_back(build(values, i, level - 1));
+    }
+    return node;
+}
+
+// Get number of values
+int PersistentStore::getSize() const
+{
+    return size;
+}
+
+// Get value by index
+expr PersistentStore::get(int index) const
+{
+    StoreNode* node = root.get();
+    for (int level = depth; level > 0; level--)
+    {
+        int shift = 1;
+        for (int i = 1; i < level; i++)
+        {
+            shift *= STORE_BRANCHING;
+        }
+        node = node->children.at(index / shift / STORE_BRANCHING % STORE_BRANCHING).get();
+    }
+    return node->values.at(index % STORE_BRANCHING);
+}
+
+// Set value by index without affecting the other copies of the store
+void PersistentStore::set(int index, expr value)
+{
+    if (root.use_count() > 1)
+    {
+        root = std::make_shared<StoreNode>(*root);
+    }
+    StoreNode* node = root.get();
+    for (int level = depth; level > 0; level--)
+    {
+        int shift = 1;
+        for (int i = 1; i < level; i++)
+        {
+            shift *= STORE_BRANCHING;
+        }
+        auto& child = node->children.at(index / shift / STORE_BRANCHING % STORE_BRANCHING);
+        if (child.use_count() > 1)
+        {
+            child = std::make_shared<StoreNode>(*child);
+        }
+        node = child.get();
+    }
+    node->values.at(index % STORE_BRANCHING) = value;
+}
@@ -0,0 +1,40 @@
+#ifndef PERSISTENTSTORE_H
+#define PERSISTENTSTORE_H
+
+#define STORE_BRANCHING 16
+
+#include <vector>
+#include <memory>
+#include <z3++.h>
+
+using namespace z3;
+
+// Dense array of Z3 expressions indexed by identifier ID.
+// Copies share structure: copying the store is O(1), and a write clones
+// only the nodes on the way to the written entry that are still shared
+// with another copy. An unshared store is updated in place.
+class PersistentStore
+{
+    struct StoreNode
+    {
+        std::vector<std::shared_ptr<StoreNode>> children;   // Inner node: subtrees
+        std::vector<expr> values;                           // Leaf: up to STORE_BRANCHING values
+    };
+
+    std::shared_ptr<StoreNode> root;
+    int size;
+    int depth;                                              // Number of inner levels above the leaves
+
+    std::shared_ptr<StoreNode> build(const std::vector<expr>& values, int first, int level);
+
+public:
+    PersistentStore();
+    PersistentStore(const std::vector<expr>& values);
+
+    int getSize() const;
+
+    expr get(int index) const;
+    void set(int index, expr value);
+};
+
+#endif
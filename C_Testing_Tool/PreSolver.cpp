@@ -0,0 +1,460 @@
+#include "PreSolver.h"
+
+#define PRESOLVER_MAX_COEFFICIENT 1000000LL
+#define PRESOLVER_MAX_SUM 4000000000000000000LL
+
+// Constructor
+PreSolver::PreSolver(context& ctx) : ctx(&ctx) {}
+
+// Switch to the recycled context. The constants of the last query belong to the old one
+void PreSolver::setContext(context& newCtx)
+{
+    ctx = &newCtx;
+    vars.clear();
+    varIndex.clear();
+}
+
+// Division rounding toward minus infinity
+int64_t floorDiv(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// Division rounding toward plus infinity
+int64_t ceilDiv(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) == (b < 0)) ? q + 1 : q;
+}
+
+int64_t gcd(int64_t a, int64_t b)
+{
+    while (b != 0)
+    {
+        int64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a < 0 ? -a : a;
+}
+
+// Add factor * e to the linear form. Returns false if e is not linear over integer constants
+// or its numbers are too large to be handled exactly
+bool PreSolver::linearize(const expr& e, std::map<int, int64_t>& terms, int64_t& constant, int64_t factor)
+{
+    if (!e.is_app() || !e.is_int())
+    {
+        return false;
+    }
+    int64_t value;
+    if (e.is_numeral())
+    {
+        if (!e.is_numeral_i64(value) || value > PRESOLVER_MAX_VALUE || value < -PRESOLVER_MAX_VALUE)
+        {
+            return false;
+        }
+        constant += factor * value;
+        return constant <= PRESOLVER_MAX_VALUE && constant >= -PRESOLVER_MAX_VALUE;
+    }
+
+    switch (e.decl().decl_kind())
+    {
+    case Z3_OP_UNINTERPRETED:
+    {
+        if (e.num_args() > 0)
+        {
+            return false;
+        }
+        auto it = varIndex.find(e.id());
+        if (it == varIndex.end())
+        {
+            it = varIndex.emplace(e.id(), vars.size()).first;
+            vars.push_back(e);
+        }
+        int64_t& coefficient = terms[it->second];
+        coefficient += factor;
+        return coefficient <= PRESOLVER_MAX_COEFFICIENT && coefficient >= -PRESOLVER_MAX_COEFFICIENT;
+    }
+
+    case Z3_OP_ADD:
+        for (int i = 0; i < e.num_args(); i++)
+        {
+            if (!linearize(e.arg(i), terms, constant, factor))
+            {
+                return false;
+            }
+        }
+        return true;
+
+    case Z3_OP_SUB:
+        for (int i = 0; i < e.num_args(); i++)
+        {
+            if (!linearize(e.arg(i), terms, constant, i == 0 ? factor : -factor))
+            {
+                return false;
+            }
+        }
+        return true;
+
+    case Z3_OP_UMINUS:
+        return linearize(e.arg(0), terms, constant, -factor);
+
+    case Z3_OP_MUL:
+    {
+        // Linear only if all the factors but one are numbers
+        int variableArg = -1;
+        for (int i = 0; i < e.num_args(); i++)
+        {
+            if (!e.arg(i).is_numeral())
+            {
+                if (variableArg >= 0)
+                {
+                    return false;
+                }
+                variableArg = i;
+            }
+            else if (!e.arg(i).is_numeral_i64(value) || value > PRESOLVER_MAX_COEFFICIENT || value < -PRESOLVER_MAX_COEFFICIENT)
+            {
+                return false;
+            }
+            else
+            {
+                factor *= value;
+                if (factor > PRESOLVER_MAX_COEFFICIENT || factor < -PRESOLVER_MAX_COEFFICIENT)
+                {
+                    return false;
+                }
+            }
+        }
+        return variableArg < 0 || linearize(e.arg(variableArg), terms, constant, factor);
+    }
+
+    default:
+        return false;
+    }
+}
+
+// Store constraint sum(terms) <= bound, or sum(terms) != bound, divided by the common divisor
+// of the coefficients. Returns false if the constraint has no variables and does not hold
+bool PreSolver::addConstraint(const std::map<int, int64_t>& terms, int64_t bound, bool isDisequality)
+{
+    LinearConstraint constraint;
+    int64_t divisor = 0;
+    for (auto& term : terms)
+    {
+        if (term.second != 0)
+        {
+            constraint.terms.push_back(term);
+            divisor = gcd(divisor, term.second);
+        }
+    }
+    if (constraint.terms.empty())
+    {
+        return isDisequality ? bound != 0 : bound >= 0;
+    }
+    if (isDisequality && bound % divisor != 0)
+    {
+        return true;                                    // no integer solution of the equality, so it always holds
+    }
+    for (auto& term : constraint.terms)
+    {
+        term.second /= divisor;
+    }
+    constraint.bound = floorDiv(bound, divisor);
+    (isDisequality ? disequalities : constraints).push_back(constraint);
+    return true;
+}
+
+// Add comparison of integer terms, or its negation. Returns false if it is not linear
+bool PreSolver::addComparison(const expr& atom, bool positive, bool& isFalse)
+{
+    if (atom.num_args() != 2 || !atom.arg(0).is_int() || !atom.arg(1).is_int())
+    {
+        return false;
+    }
+    std::map<int, int64_t> terms;                       // atom compares sum(terms) + constant with 0
+    int64_t constant = 0;
+    if (!linearize(atom.arg(0), terms, constant, 1) || !linearize(atom.arg(1), terms, constant, -1))
+    {
+        return false;
+    }
+    std::map<int, int64_t> negated;
+    for (auto& term : terms)
+    {
+        negated[term.first] = -term.second;
+    }
+
+    bool holds = true;
+    switch (atom.decl().decl_kind())
+    {
+    case Z3_OP_LE:
+        holds = positive ? addConstraint(terms, -constant, false) : addConstraint(negated, constant - 1, false);
+        break;
+
+    case Z3_OP_GE:
+        holds = positive ? addConstraint(negated, constant, false) : addConstraint(terms, -constant - 1, false);
+        break;
+
+    case Z3_OP_LT:
+        holds = positive ? addConstraint(terms, -constant - 1, false) : addConstraint(negated, constant, false);
+        break;
+
+    case Z3_OP_GT:
+        holds = positive ? addConstraint(negated, constant - 1, false) : addConstraint(terms, -constant, false);
+        break;
+
+    case Z3_OP_EQ:
+        holds = positive ?
+            addConstraint(terms, -constant, false) && addConstraint(negated, constant, false) :
+            addConstraint(terms, -constant, true);
+        break;
+
+    default:
+        return false;
+    }
+    isFalse = isFalse || !holds;
+    return true;
+}
+
+// Collect the linear constraints the formula, or its negation, implies. Returns false if the formula
+// has parts that are not linear. Sets isFalse if a part folds to false
+bool PreSolver::collect(const expr& e, bool positive, bool& isFalse)
+{
+    if (e.is_true() || e.is_false())
+    {
+        isFalse = isFalse || e.is_true() != positive;
+        return true;
+    }
+    if (!e.is_app())
+    {
+        return false;
+    }
+    switch (e.decl().decl_kind())
+    {
+    case Z3_OP_NOT:
+        return collect(e.arg(0), !positive, isFalse);
+
+    case Z3_OP_AND: case Z3_OP_OR:
+    {
+        if ((e.decl().decl_kind() == Z3_OP_AND) != positive)
+        {
+            return false;                               // disjunction
+        }
+        bool understood = true;
+        for (int i = 0; i < e.num_args(); i++)
+        {
+            understood = collect(e.arg(i), positive, isFalse) && understood;
+        }
+        return understood;
+    }
+
+    case Z3_OP_LE: case Z3_OP_GE: case Z3_OP_LT: case Z3_OP_GT: case Z3_OP_EQ:
+        return addComparison(e, positive, isFalse);
+
+    default:
+        return false;
+    }
+}
+
+// Propagate bounds of the variables through the constraints. Returns false if an interval gets empty
+bool PreSolver::propagate()
+{
+    intervals.assign(vars.size(), Interval{ false, false, 0, 0 });
+    bool changed = true;
+    for (int round = 0; round < PRESOLVER_MAX_ROUNDS && changed; round++)
+    {
+        changed = false;
+        for (auto& constraint : constraints)
+        {
+            // Least value of every term, and of their sum over the bounded ones
+            std::vector<int64_t> least(constraint.terms.size());
+            std::vector<bool> bounded(constraint.terms.size());
+            int64_t sum = 0;
+            int unbounded = 0;
+            for (int i = 0; i < constraint.terms.size() && unbounded <= 1; i++)
+            {
+                int64_t coefficient = constraint.terms.at(i).second;
+                const Interval& interval = intervals.at(constraint.terms.at(i).first);
+                bounded.at(i) = coefficient > 0 ? interval.hasLow : interval.hasHigh;
+                if (bounded.at(i))
+                {
+                    least.at(i) = coefficient * (coefficient > 0 ? interval.low : interval.high);
+                    sum += least.at(i);
+                }
+                else
+                {
+                    unbounded++;
+                }
+                if (sum > PRESOLVER_MAX_SUM || sum < -PRESOLVER_MAX_SUM)
+                {
+                    unbounded = 2;                      // too large to be exact, the constraint is skipped
+                }
+            }
+
+            // coefficient * x <= bound - least value of the other terms
+            for (int i = 0; i < constraint.terms.size(); i++)
+            {
+                if (unbounded > 1 || (unbounded == 1 && bounded.at(i)))
+                {
+                    continue;
+                }
+                int64_t rest = constraint.bound - (bounded.at(i) ? sum - least.at(i) : sum);
+                int64_t coefficient = constraint.terms.at(i).second;
+                Interval& interval = intervals.at(constraint.terms.at(i).first);
+                if (coefficient > 0)
+                {
+                    int64_t high = floorDiv(rest, coefficient);
+                    if (high >= -PRESOLVER_MAX_VALUE && high <= PRESOLVER_MAX_VALUE && (!interval.hasHigh || high < interval.high))
+                    {
+                        interval.hasHigh = true;
+                        interval.high = high;
+                        changed = true;
+                    }
+                }
+                else
+                {
+                    int64_t low = ceilDiv(rest, coefficient);
+                    if (low >= -PRESOLVER_MAX_VALUE && low <= PRESOLVER_MAX_VALUE && (!interval.hasLow || low > interval.low))
+                    {
+                        interval.hasLow = true;
+                        interval.low = low;
+                        changed = true;
+                    }
+                }
+                if (interval.hasLow && interval.hasHigh && interval.low > interval.high)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    // A disequality fails if all its variables are fixed to values that make it an equality
+    for (auto& disequality : disequalities)
+    {
+        bool fixed = true;
+        int64_t sum = 0;
+        for (auto& term : disequality.terms)
+        {
+            const Interval& interval = intervals.at(term.first);
+            fixed = fixed && interval.hasLow && interval.hasHigh && interval.low == interval.high &&
+                sum <= PRESOLVER_MAX_SUM && sum >= -PRESOLVER_MAX_SUM;
+            sum += fixed ? term.second * interval.low : 0;
+        }
+        if (fixed && sum == disequality.bound)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Solve the difference bounds x - y <= k and the intervals by shortest distances from a zero node.
+// Returns false if the graph has a negative cycle
+bool PreSolver::findModel(std::vector<int64_t>& values)
+{
+    int zero = vars.size();
+    std::vector<std::tuple<int, int, int64_t>> edges;   // Source, target and weight: target - source <= weight
+    for (auto& constraint : constraints)
+    {
+        if (constraint.terms.size() == 2 && constraint.terms.at(0).second * constraint.terms.at(1).second == -1)
+        {
+            bool firstPositive = constraint.terms.at(0).second > 0;
+            int target = constraint.terms.at(firstPositive ? 0 : 1).first;
+            int source = constraint.terms.at(firstPositive ? 1 : 0).first;
+            edges.emplace_back(source, target, constraint.bound);
+        }
+    }
+    for (int i = 0; i < vars.size(); i++)
+    {
+        if (intervals.at(i).hasHigh)
+        {
+            edges.emplace_back(zero, i, intervals.at(i).high);
+        }
+        if (intervals.at(i).hasLow)
+        {
+            edges.emplace_back(i, zero, -intervals.at(i).low);
+        }
+    }
+
+    // Bellman-Ford from a source connected to every node by a zero edge
+    std::vector<int64_t> distances(vars.size() + 1, 0);
+    for (int round = 0; round <= vars.size() + 1; round++)
+    {
+        bool relaxed = false;
+        for (auto& edge : edges)
+        {
+            int64_t distance = distances.at(std::get<0>(edge)) + std::get<2>(edge);
+            if (distance < distances.at(std::get<1>(edge)))
+            {
+                distances.at(std::get<1>(edge)) = distance;
+                relaxed = true;
+            }
+        }
+        if (!relaxed)
+        {
+            values.clear();
+            for (int i = 0; i < vars.size(); i++)
+            {
+                values.push_back(distances.at(i) - distances.at(zero));
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// Decide the query. Returns unknown if it has to go to Z3
+check_result PreSolver::check(const std::vector<expr>& query, model& m)
+{
+    vars.clear();
+    varIndex.clear();
+    constraints.clear();
+    disequalities.clear();
+    bool isFalse = false;
+    for (auto& constraint : query)
+    {
+        collect(constraint, true, isFalse);
+    }
+    std::vector<int64_t> values;
+    if (isFalse || !propagate() || !findModel(values))
+    {
+        return unsat;
+    }
+
+    // Candidate model: the integer variables take the distances, other constants their default values
+    model candidate(*ctx);
+    model defaults(*ctx);
+    std::set<unsigned> visited;
+    std::vector<expr> stack(query.begin(), query.end());
+    while (!stack.empty())
+    {
+        expr curr = stack.back();
+        stack.pop_back();
+        if (!curr.is_app() || !visited.insert(curr.id()).second)
+        {
+            continue;
+        }
+        if (curr.is_const() && curr.decl().decl_kind() == Z3_OP_UNINTERPRETED)
+        {
+            auto it = varIndex.find(curr.id());
+            func_decl decl = curr.decl();
+            expr value = it != varIndex.end() ? ctx->int_val(values.at(it->second)) : defaults.eval(curr, true);
+            candidate.add_const_interp(decl, value);
+        }
+        for (int i = 0; i < curr.num_args(); i++)
+        {
+            stack.push_back(curr.arg(i));
+        }
+    }
+    for (auto& constraint : query)
+    {
+        if (!candidate.eval(constraint, true).is_true())
+        {
+            return unknown;
+        }
+    }
+    m = candidate;
+    return sat;
+}
@@ -0,0 +1,59 @@
+#ifndef PRESOLVER_H
+#define PRESOLVER_H
+
+#define PRESOLVER_MAX_VALUE 1000000000000LL             // Larger constants and bounds are left to Z3
+#define PRESOLVER_MAX_ROUNDS 16                         // Passes of bound propagation
+
+#include <vector>
+#include <map>
+#include <set>
+#include <tuple>
+#include <cstdint>
+#include <z3++.h>
+
+using namespace z3;
+
+// Decides simple queries without Z3. Constraints are folded to constants, and the ones that are
+// linear over integer variables are brought to the form sum(a_i * x_i) <= k. Then
+//   - bounds of the variables are propagated through the constraints until an interval is empty;
+//   - the constraints over two variables, x - y <= k, and the bounds form a graph of difference
+//     bounds, and a negative cycle in it proves the query unsatisfiable;
+//   - otherwise the shortest distances in the graph are a candidate model. It is checked against
+//     the whole query, so the constraints the pre-solver does not understand only make it give up.
+class PreSolver
+{
+    struct LinearConstraint
+    {
+        std::vector<std::pair<int, int64_t>> terms;     // Variable index and its coefficient
+        int64_t bound;                                  // sum of the terms <= bound, or != bound
+    };
+
+    struct Interval
+    {
+        bool hasLow, hasHigh;
+        int64_t low, high;
+    };
+
+    context* ctx;
+    std::vector<expr> vars;                             // Integer constants of the query
+    std::map<unsigned, int> varIndex;                   // Index in vars by AST ID
+    std::vector<LinearConstraint> constraints;
+    std::vector<LinearConstraint> disequalities;
+    std::vector<Interval> intervals;
+
+    bool linearize(const expr& e, std::map<int, int64_t>& terms, int64_t& constant, int64_t factor);
+    bool addComparison(const expr& atom, bool positive, bool& isFalse);
+    bool collect(const expr& e, bool positive, bool& isFalse);
+    bool addConstraint(const std::map<int, int64_t>& terms, int64_t bound, bool isDisequality);
+    bool propagate();
+    bool findModel(std::vector<int64_t>& values);
+
+public:
+    PreSolver(context& ctx);
+
+    void setContext(context& newCtx);
+
+    check_result check(const std::vector<expr>& query, model& m);
+};
+
+#endif
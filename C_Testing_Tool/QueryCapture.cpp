@@ -0,0 +1,186 @@
+#include "QueryCapture.h"
+#include "Solver.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define makeDirectory(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define makeDirectory(path) mkdir(path, 0755)
+#endif
+
+// Constructor. An empty directory disables the capture
+QueryCapture::QueryCapture(std::string directory) : directory(directory)
+{
+    nextNumber = 1;
+    if (isEnabled())
+    {
+        makeDirectory(directory.c_str());
+        while (std::ifstream(getFileName(directory, nextNumber)).is_open())
+        {
+            nextNumber++;
+        }
+    }
+}
+
+bool QueryCapture::isEnabled() const
+{
+    return !directory.empty();
+}
+
+// Name of the captured query file with the number
+std::string QueryCapture::getFileName(const std::string& directory, int number)
+{
+    std::ostringstream name;
+    name << directory << "/" << CAPTURE_FILE_PREFIX << std::setw(CAPTURE_NUMBER_DIGITS) << std::setfill('0') << number;
+    return name.str() + CAPTURE_FILE_EXTENSION;
+}
+
+// Write the assertions of the solver and the assumptions of the query as a script of their own
+void QueryCapture::write(solver& solver, const expr_vector& assumptions, int pathId, int nodeId, double time, check_result result)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    context& ctx = solver.ctx();
+    expr_vector formulas = solver.assertions();
+    for (int i = 0; i < assumptions.size(); i++)
+    {
+        formulas.push_back(assumptions[i]);
+    }
+    if (formulas.empty())
+    {
+        formulas.push_back(ctx.bool_val(true));
+    }
+    std::vector<Z3_ast> others;
+    for (int i = 0; i + 1 < formulas.size(); i++)
+    {
+        others.push_back(formulas[i]);
+    }
+    std::ostringstream status;
+    status << result;
+    std::string script = Z3_benchmark_to_smtlib_string(
+        ctx, "", "", status.str().c_str(), "", others.size(), others.data(), formulas[formulas.size() - 1]
+    );
+
+    std::ofstream file(getFileName(directory, nextNumber++));
+    file << "; path: " << pathId << "\n";
+    file << "; node: " << nodeId << "\n";
+    file << "; time: " << std::fixed << std::setprecision(3) << time << "\n";
+    file << "; result: " << status.str() << "\n";
+    file << script;
+}
+
+// Read the metadata comments at the top of a captured query. Returns false if the file does not open
+bool QueryCapture::readMetadata(const std::string& fileName, CapturedQuery& query)
+{
+    std::ifstream file(fileName);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    query.fileName = fileName;
+    query.pathId = -1;
+    query.nodeId = -1;
+    query.time = 0;
+    query.result = "unknown";
+    std::string line;
+    while (std::getline(file, line) && line.compare(0, 2, "; ") == 0)
+    {
+        std::istringstream fields(line.substr(2));
+        std::string name;
+        fields >> name;
+        if (name == "path:")
+        {
+            fields >> query.pathId;
+        }
+        else if (name == "node:")
+        {
+            fields >> query.nodeId;
+        }
+        else if (name == "time:")
+        {
+            fields >> query.time;
+        }
+        else if (name == "result:")
+        {
+            fields >> query.result;
+        }
+    }
+    return true;
+}
+
+// Check every captured query of the directory again with a solver built from the options, each in
+// a fresh context, and print its captured and new time and result. A query whose new definite
+// result contradicts the captured one is marked with '!'
+void QueryCapture::replay(const std::string& directory, const SolverOptions& options)
+{
+    if (!std::ifstream(getFileName(directory, 1)).is_open())
+    {
+        std::cout << "No captured queries in " << directory << "\n";
+        return;
+    }
+    const int nameWidth = 20;
+    const int columnWidth = 10;
+    std::cout << std::left << std::setw(nameWidth) << "Query" << std::right;
+    std::cout << std::setw(columnWidth) << "Path" << std::setw(columnWidth) << "Node";
+    std::cout << std::setw(columnWidth) << "Result" << std::setw(columnWidth) << "Time, ms";
+    std::cout << std::setw(columnWidth) << "Replayed" << std::setw(columnWidth) << "Time, ms" << "\n";
+
+    int count = 0;
+    int mismatches = 0;
+    double capturedTotal = 0;
+    double replayedTotal = 0;
+    CapturedQuery slowest;
+    double slowestTime = -1;
+    CapturedQuery query;
+    for (int number = 1; readMetadata(getFileName(directory, number), query); number++)
+    {
+        std::string replayed;
+        double time = 0;
+        try
+        {
+            context ctx;
+            expr_vector formulas = ctx.parse_file(query.fileName.c_str());
+            solver s = options.createSolver(ctx);
+            for (int i = 0; i < formulas.size(); i++)
+            {
+                s.add(formulas[i]);
+            }
+            auto start = std::chrono::steady_clock::now();
+            std::ostringstream result;
+            result << s.check();
+            time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            replayed = result.str();
+        }
+        catch (z3::exception& e)
+        {
+            replayed = "error";
+            std::cout << query.fileName << ": " << e.msg() << "\n";
+        }
+        bool mismatch = replayed != "unknown" && query.result != "unknown" && replayed != query.result;
+
+        count++;
+        mismatches += mismatch ? 1 : 0;
+        capturedTotal += query.time;
+        replayedTotal += time;
+        if (time > slowestTime)
+        {
+            slowest = query;
+            slowestTime = time;
+        }
+        std::string shortName = query.fileName.substr(query.fileName.find_last_of("\\/") + 1);
+        std::cout << std::left << std::setw(nameWidth) << shortName << std::right;
+        std::cout << std::setw(columnWidth) << query.pathId << std::setw(columnWidth) << query.nodeId;
+        std::cout << std::setw(columnWidth) << query.result;
+        std::cout << std::fixed << std::setprecision(2) << std::setw(columnWidth) << query.time;
+        std::cout << std::setw(columnWidth) << replayed << std::setw(columnWidth) << time << (mismatch ? " !" : "") << "\n";
+    }
+
+    std::cout << "\nQueries: " << count << ", results changed: " << mismatches << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Total time: " << capturedTotal << " ms captured, " << replayedTotal << " ms replayed\n";
+    std::cout << "Slowest: " << slowest.fileName << " (path " << slowest.pathId << ", node " << slowest.nodeId;
+    std::cout << ") - " << slowestTime << " ms\n";
+}
@@ -0,0 +1,55 @@
+#ifndef QUERYCAPTURE_H
+#define QUERYCAPTURE_H
+
+#define CAPTURE_FILE_PREFIX "query_"
+#define CAPTURE_FILE_EXTENSION ".smt2"
+#define CAPTURE_NUMBER_DIGITS 6
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <z3++.h>
+
+using namespace z3;
+
+struct SolverOptions;
+
+// Queries sent to Z3, each written as a standalone SMT-LIB2 script with its metadata in comments:
+//   ; path: <index of the path in the search, -1 outside of it>
+//   ; node: <ID of the CFG node whose constraint was checked>
+//   ; time: <milliseconds the query took>
+//   ; result: <sat, unsat or unknown>
+// The files are numbered in the order of the queries, after the files of earlier runs.
+// The replay checks every captured script again and compares the times and results
+class QueryCapture
+{
+    struct CapturedQuery
+    {
+        std::string fileName;
+        int pathId;
+        int nodeId;
+        double time;
+        std::string result;
+    };
+
+    std::string directory;
+    int nextNumber;
+
+    static std::string getFileName(const std::string& directory, int number);
+    static bool readMetadata(const std::string& fileName, CapturedQuery& query);
+
+public:
+    QueryCapture(std::string directory = "");
+
+    bool isEnabled() const;
+
+    void write(solver& solver, const expr_vector& assumptions, int pathId, int nodeId, double time, check_result result);
+
+    static void replay(const std::string& directory, const SolverOptions& options);
+};
+
+#endif
@@ -4,973 +4,4249 @@ using namespace z3;
 
 //.........................SYMBOLIC CONTEXT
 
-// Constructor
-SymbolicContext::SymbolicContext()
+// Constructor. Takes over a context created in advance, or creates one
+SymbolicContext::SymbolicContext(std::unique_ptr<context> ctx) : ctx(ctx ? std::move(ctx) : std::unique_ptr<context>(new context)),
+    placeholders(*this->ctx)
 {
-    vars = {};
+    varIds = {};
+    machineArithmetic = false;
+    stringTheory = false;
 }
 
 // Import variables from source code as Z3 expressions
 void SymbolicContext::importVars(vector<Identifier> ids)
 {
+    std::vector<expr> values;
     for (int idIndex = 0; idIndex < ids.size(); idIndex++)
     {
         idType id_type = ids.at(idIndex).getIdType();
+        expr varExpr = ctx->int_val(DEFAULT_NUM_VALUE);          // placeholder entry for non-variables
         if (id_type == STD_VAR || id_type == INPUT_VAR)
         {
             std::string varName = ids.at(idIndex).getName();
             lexeme dataType = ids.at(idIndex).getDataType();
-            expr varExpr = ctx.int_const(varName.c_str());
+            varExpr = machineArithmetic ? ctx->bv_const(varName.c_str(), INT_BITS) : ctx->int_const(varName.c_str());
             switch (dataType)
             {
-            case LEX_FLOAT: case LEX_DOUBLE:
-                varExpr = ctx.real_const(varName.c_str());
+            case LEX_FLOAT:
+                varExpr = machineArithmetic ? ctx->fpa_const(varName.c_str(), FLOAT_EBITS, FLOAT_SBITS) : ctx->real_const(varName.c_str());
+                break;
+
+            case LEX_DOUBLE:
+                varExpr = machineArithmetic ? ctx->fpa_const(varName.c_str(), DOUBLE_EBITS, DOUBLE_SBITS) : ctx->real_const(varName.c_str());
                 break;
 
             case LEX_BOOL:
-                varExpr = ctx.bool_const(varName.c_str());
+                varExpr = ctx->bool_const(varName.c_str());
+                break;
+
+            case LEX_CHAR:
+                varExpr = stringTheory ? ctx->string_const(varName.c_str()) : ctx->bv_const(varName.c_str(), CHAR_BITS);
                 break;
 
-            case LEX_CHAR: case LEX_STRING:
-                varExpr = ctx.string_const(varName.c_str());
+            case LEX_STRING:
+                varExpr = stringTheory ? ctx->string_const(varName.c_str()) : ctx->bv_const(varName.c_str(), CHAR_BITS * STRING_MAX_LENGTH);
                 break;
 
             default:
                 break;
             }
-            vars.push_back(std::make_pair(idIndex, varExpr));
+            std::string placeholderName = "!" + varName;
+            varPositions[idIndex] = varIds.size();
+            initVarIds[varExpr.id()] = idIndex;
+            varIds.push_back(idIndex);
+            placeholders.push_back(ctx->constant(placeholderName.c_str(), varExpr.get_sort()));
         }
+        values.push_back(varExpr);
     }
+    initVars = PersistentStore(values);
+    vars = initVars;
 }
 
 // Reset values of all variables
-void SymbolicContext::resetVars(vector<Identifier> ids)
+void SymbolicContext::resetVars()
 {
-    vars.clear();
-    importVars(ids);
+    vars = initVars;
 }
 
-int SymbolicContext::getIndex(int val) const
+// Declare the variables again in a fresh context. The old context is returned, to be released
+// by the caller after the last expression of it, since an expression outliving its context
+// cannot be freed
+std::unique_ptr<context> SymbolicContext::renewContext(vector<Identifier> ids)
 {
-    auto isPresent = [val](const pair<int, expr>& entry) { return entry.first == val; };
-    auto it = std::find_if(vars.begin(), vars.end(), isPresent);
-    if (it != vars.end())
-    {
-        int index = std::distance(vars.begin(), it);
-        return index;
-    }
-    return -1;
+    std::unique_ptr<context> old = std::move(ctx);
+    ctx.reset(new context);
+    placeholders = expr_vector(*ctx);
+    varIds.clear();
+    varPositions.clear();
+    initVarIds.clear();
+    importVars(ids);
+    return old;
 }
 
 expr SymbolicContext::getExpr(int val) const
 {
-    return vars.at(getIndex(val)).second;
+    return vars.get(val);
 }
 
 void SymbolicContext::setExpr(int val, expr newExpr)
 {
-    vars.at(getIndex(val)).second = newExpr;
+    vars.set(val, newExpr);
 }
 
+// Replace values of all variables with their placeholders
+void SymbolicContext::usePlaceholders()
+{
+    for (int i = 0; i < varIds.size(); i++)
+    {
+        vars.set(varIds.at(i), placeholders[i]);
+    }
+}
 
-//.........................TEST CASE CLASS
-
-// Constructor for infeasible test case
-TestCase::TestCase()
+// Get current values of all variables in the order of their placeholders
+expr_vector SymbolicContext::getCurrentValues()
 {
-    sat = false;
+    expr_vector values(*ctx);
+    for (auto& idIndex : varIds)
+    {
+        values.push_back(vars.get(idIndex));
+    }
+    return values;
 }
 
-// Constructor for feasible test case
-TestCase::TestCase(std::vector<Identifier> funcParams, expr_vector evals, expr returnVal) : ids(funcParams)
+// Collect identifier IDs of the initial values the expression reads
+std::vector<int> SymbolicContext::getInputIds(const expr& e) const
 {
-    sat = true;
-    if (evals.size() == 0)
+    std::set<int> inputIds;
+    std::set<unsigned> visited;
+    std::vector<expr> stack{ e };
+    while (!stack.empty())
     {
-        for (int i = 0; i < ids.size(); i++)
+        expr curr = stack.back();
+        stack.pop_back();
+        if (!curr.is_app() || !visited.insert(curr.id()).second)
         {
-            values.push_back("Any value");
+            continue;
         }
-    }
-    else
-    {
-        for (int i = 0; i < ids.size(); i++)
+        auto it = initVarIds.find(curr.id());
+        if (it != initVarIds.end())
+        {
+            inputIds.insert(it->second);
+        }
+        for (int i = 0; i < curr.num_args(); i++)
         {
-            values.push_back(evals[i].to_string());
+            stack.push_back(curr.arg(i));
         }
     }
-    output = returnVal.simplify().to_string();
+    return std::vector<int>(inputIds.begin(), inputIds.end());
 }
 
-// Get test case feasibility
-bool TestCase::isFeasible()
+// Make integer constant of the sort of int
+expr SymbolicContext::intVal(int value)
 {
-    return sat;
+    return machineArithmetic ? ctx->bv_val(value, INT_BITS) : ctx->int_val(value);
 }
 
-// Get number of input variables
-int TestCase::getSize()
+// Make floating constant of the sort of double from its value and fraction
+expr SymbolicContext::realVal(double value, int numerator, int denominator)
 {
-    return values.size();
+    return machineArithmetic ? ctx->fpa_val(value) : ctx->real_val(numerator, denominator);
 }
 
-// Get identifier
-Identifier TestCase::getId(int index)
+// Make character constant of the sort of char
+expr SymbolicContext::charVal(char value)
 {
-    return ids.at(index);
+    return stringTheory ? ctx->string_val(std::string(1, value)) : ctx->bv_val((unsigned) (unsigned char) value, CHAR_BITS);
 }
 
-// Get value of the identifier
-string TestCase::getIdValue(int index)
+// Make string constant of the sort of char*. Bytes past STRING_MAX_LENGTH are cut off
+expr SymbolicContext::strVal(const std::string& value)
 {
-    return values.at(index);
+    if (stringTheory)
+    {
+        return ctx->string_val(value);
+    }
+    expr_vector bytes(*ctx);
+    for (int i = STRING_MAX_LENGTH - 1; i >= 0; i--)
+    {
+        unsigned byte = i < value.size() ? (unsigned char) value.at(i) : 0;
+        bytes.push_back(ctx->bv_val(byte, CHAR_BITS));
+    }
+    return concat(bytes).simplify();
 }
 
-// Get the function output
-string TestCase::getOutput()
-{
-    return output;
-}
 
+//.........................SOLVER OPTIONS AND STATISTICS
 
-//.........................SMT SOLVER CLASS
-void Solver::collectPaths(int id, Path currPath, std::set<int> visitedNodes, int loopIterCount = 0)
+// Default options
+SolverOptions::SolverOptions()
 {
-    Node& node = cfg.nodes[id];
-    currPath.push_back(node);
-    visitedNodes.insert(id);
+    engine = ENGINE_PATHS;
+    goal = GOAL_ALL_PATHS;
+    pathBudget = 0;
+    timeBudget = 0;
+    queryBudget = 0;
+    memoryBudget = 0;
+    recyclePaths = 0;
+    recycleMemory = 0;
+    queryTimeout = 5000;
+    portfolio = true;
+    portfolioThreshold = 1000;
+    policy = CHECK_ON_CONSTRAINT;
+    checkBatchSize = 4;
+    summarizeLoops = true;
+    loopVisits = 2;
+    initialLoopBound = 16;
+    loopBoundGrowth = 4;
+    sliceConstraints = true;
+    cacheQueries = true;
+    modelsPerPath = 1;
+    presolve = true;
+    intervalAnalysis = true;
+    staticSlicing = true;
+    warmupContext = true;
+    pruneByCores = true;
+    cacheDirectory = "";
+    captureDirectory = "";
+    machineArithmetic = false;
+    stringTheory = false;
+    mergeStates = false;
+    mergeMaxVars = 4;
+    mergeMaxSize = 64;
+    unrollBound = 8;
+}
 
-    if (node.edges.empty())
+// Set a Z3 parameter given as text: true and false are Boolean, digits are unsigned,
+// other numbers are doubles and anything else is a symbol
+void setParam(params& p, const std::string& name, const std::string& value)
+{
+    char* end = nullptr;
+    double number = std::strtod(value.c_str(), &end);
+    if (value == "true" || value == "false")
     {
-        paths.push_back(currPath);
+        p.set(name.c_str(), value == "true");
     }
-    else
+    else if (!value.empty() && std::all_of(value.begin(), value.end(), ::isdigit))
     {
-        Token branch = node.code.front();
-        if (branch.getLexeme() == LEX_WHILE || branch.getLexeme() == LEX_FOR)
-        {
-            loopIterCount++;
-        }
-
-        if (node.edges.size() == 1 && !node.edges.front().condition.empty())
-        {
-            paths.push_back(currPath);
-            collectPaths(node.edges.front().idTarget, currPath, visitedNodes, loopIterCount);
-        }
-        else
-        {
-            for (const auto& edge : node.edges)
-            {
-                //if (visitedNodes.count(edge.idTarget) == 0 || edge.condition.empty())
-                if (loopIterCount <= 2 || edge.condition.empty())
-                {
-                    collectPaths(edge.idTarget, currPath, visitedNodes, loopIterCount);
-                }
-            }
-        }
+        p.set(name.c_str(), (unsigned) std::stoul(value));
     }
-}
-
-Token Solver::getLexeme(const std::vector<Token>& line, int& index, lexeme& type)
-{
-    if (index >= line.size())
+    else if (end != value.c_str() && *end == '\0')
     {
-        return Token(LEX_FIN, LEX_FIN);
+        p.set(name.c_str(), number);
+    }
+    else
+    {
+        p.set(name.c_str(), p.ctx().str_symbol(value.c_str()));
     }
-    int i = index;
-    type = line.at(i).getLexeme();
-    index++;
-    return line.at(i);
 }
 
-void Solver::ungetLexeme(const std::vector<Token>& line, int& index, lexeme& type)
+// Remove the whitespace around the text
+std::string trim(const std::string& text)
 {
-    if (index > 0)
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos)
     {
-        index--;
-        type = line.at(index).getLexeme();
+        return "";
     }
+    return text.substr(start, text.find_last_not_of(" \t\r\n") - start + 1);
 }
 
-void Solver::solveStatement(const std::vector<Token>& code, solver& solver)
+// Read true or false. Returns false for any other text
+bool parseFlag(const std::string& value, bool& flag)
 {
-    // reset index to start parsing codeline from the first token
-    int index = 0;
-	lexeme type = LEX_NULL;
-    
-    auto codeIt = std::find_if(
-        code.begin(),
-        code.end(),
-        [](Token lex)
-        {
-            return (
-                lex.getLexeme() == LEX_ASSIGN ||
-                lex.getLexeme() >= LEX_INT && lex.getLexeme() <= LEX_STRING ||
-                lex.getLexeme() >= LEX_PLUS_ASSIGN && lex.getLexeme() <= LEX_SLASH_ASSIGN
-            );
-        }
-    );
-    if (codeIt != code.end())
-    {
-        solveAssign(code, index, type);
-    }
-    else
+    if (value != "true" && value != "false")
     {
-        EXPR(code, index, type);
+        return false;
     }
+    flag = value == "true";
+    return true;
 }
 
-void Solver::solveAssign(const std::vector<Token>& code, int& index, lexeme& type)
+// Read a whole number of at most nine digits. Returns false for any other text
+bool parseCount(const std::string& value, int& count)
 {
-    Token lex = getLexeme(code, index, type);
-    lexeme idType = LEX_NULL;
-    if (type >= LEX_INT && type <= LEX_STRING)
-    {
-        idType = type;
-        lex = getLexeme(code, index, type);
-    }
-    if (type == LEX_ID)
+    if (value.empty() || value.size() > 9 || !std::all_of(value.begin(), value.end(), ::isdigit))
     {
-        int idVal = lex.getValue();
-        getLexeme(code, index, type);
-        expr assignExpr = sym.getExpr(idVal);
-        switch (type)
-        {
-        case LEX_ASSIGN:
-            sym.setExpr(idVal, EXPR(code, index, type));
-            break;
-
-        case LEX_PLUS_ASSIGN:
-            sym.setExpr(idVal, sym.getExpr(idVal) + EXPR(code, index, type));
-            break;
-
-        case LEX_MINUS_ASSIGN:
-            sym.setExpr(idVal, sym.getExpr(idVal) - EXPR(code, index, type));
-            break;
-
-        case LEX_TIMES_ASSIGN:
-            sym.setExpr(idVal, sym.getExpr(idVal) * EXPR(code, index, type));
-            break;
-
-        case LEX_SLASH_ASSIGN:
-            sym.setExpr(idVal, sym.getExpr(idVal) / EXPR(code, index, type));
-            break;
-
-        default:
-            switch (idType)
-            {
-            case LEX_INT:
-                sym.setExpr(idVal, sym.ctx.int_val(DEFAULT_NUM_VALUE));
-                break;
-
-            case LEX_FLOAT: case LEX_DOUBLE:
-                sym.setExpr(idVal, sym.ctx.real_val(DEFAULT_NUM_VALUE));
-                break;
-
-            case LEX_CHAR:
-                sym.setExpr(idVal, sym.ctx.string_val(std::string(1, DEFAULT_CHAR_VALUE)));
-                break;
-            }
-            break;
-        }
+        return false;
     }
+    count = std::stoi(value);
+    return true;
 }
 
-expr Solver::solveCondition(const std::vector<Token>& cnd)
+// Names of the solver presets, the first is the default
+std::vector<std::string> SolverOptions::getPresetNames()
 {
-    int index = 0;
-    lexeme type;
-    expr cndExpr = sym.ctx.bool_val(true); // default
-    getLexeme(cnd, index, type);
-    if (type == LEX_LEFT_PAREN)
-    {
-        cndExpr = EXPR(cnd, index, type);
-    }
-    return cndExpr;
+    return { "default", "preprocess", "nonlinear", "legacy-arith" };
 }
 
-void Solver::solveLoop(const Path& path, solver& solver, int& currNodeIndex)
+// Set the tactic pipeline and Z3 parameters of the named preset. Returns false for an unknown name
+bool SolverOptions::applyPreset(const std::string& name)
 {
-    auto currNode = path.at(currNodeIndex);
-    int loopStartNodeId = currNode.id;
-    int loopEndIndex = 0;
-    auto it = std::find_if(
-        path.begin() + currNodeIndex + 1,
-        path.end(),
-        [loopStartNodeId](Node node)
-        {
-            return node.id == loopStartNodeId;
-        }
-    );
-    if (it != path.end())
+    if (name == "default")
     {
-        loopEndIndex = distance(path.begin(), it);
+        tactics.clear();
+        z3Params.clear();
     }
-    //cout << "Loop Start Node: " << loopStartNodeId << "\nLoop End Index: " << loopEndIndex << "\n";
-    if (loopEndIndex > 0)
+    else if (name == "preprocess")
     {
-        int loopIter = 0;
-        auto cnd = currNode.edges.front().condition;
-        expr loopCndExpr = solveCondition(cnd);
-
-        solver.push();                                  // save current state of the solver
-        solver.add(loopCndExpr);                        // add temporary expression
-        bool loopCondSat = solver.check() == sat;
-        solver.pop();                                   // erase temporary expression
-
-        Path loopBodyPath{};
-        
-        for (int k = currNodeIndex + 1; k < loopEndIndex; k++)
-        {
-            loopBodyPath.push_back(path.at(k));
-        }
-
-        currNodeIndex = loopEndIndex;
-        while (loopIter < maxIterForLoops && loopCondSat)
-        {
-            bool debug = false;
-            evaluatePathConstraints(loopBodyPath, solver, debug);
-            loopCndExpr = solveCondition(cnd);
-            solver.push();
-            solver.add(loopCndExpr);
-            loopCondSat = solver.check() == sat;
-            solver.pop();
-            loopIter++;
-        }
-        if (loopIter == maxIterForLoops)
-        {
-            solver.add(sym.ctx.bool_val(false));
-        }
+        tactics = { "simplify", "propagate-values", "solve-eqs", "smt" };
+        z3Params.clear();
     }
-    else
+    else if (name == "nonlinear")
     {
-        auto cndFalse = currNode.edges.back().condition;
-        expr cndExpr = solveCondition(cndFalse);
-        solver.add(cndExpr);
+        tactics = { "simplify", "propagate-values", "qfnia" };
+        z3Params.clear();
     }
-}
-
-expr Solver::EXPR(const std::vector<Token>& line, int& currIndex, lexeme& currType)
-{
-    expr stmntExpr = DISJ(line, currIndex, currType);
-    executeUnaryOperations();
-    return stmntExpr;
-}
-
-expr Solver::DISJ(const std::vector<Token>& line, int& currIndex, lexeme& currType)
-{
-    expr logicAddExpr = CONJ(line, currIndex, currType);
-    while (currType == LEX_OR)
+    else if (name == "legacy-arith")
     {
-        logicAddExpr = logicAddExpr || CONJ(line, currIndex, currType);
+        tactics.clear();
+        z3Params = { { "arith.solver", "2" } };
     }
-    return logicAddExpr;
-}
-
-expr Solver::CONJ(const std::vector<Token>& line, int& currIndex, lexeme& currType)
-{
-    expr logicMultiExpr = CMP(line, currIndex, currType);
-    while (currType == LEX_AND)
+    else
     {
-        logicMultiExpr = logicMultiExpr && CMP(line, currIndex, currType);
+        return false;
     }
-    return logicMultiExpr;
+    return true;
 }
 
-expr Solver::CMP(const std::vector<Token>& line, int& currIndex, lexeme& currType)
+// Load options from a file of "name = value" lines, where '#' starts a comment:
+//   preset  - the tactics and parameters of a preset, applied where the line is
+//   tactics - comma separated tactic pipeline, like simplify, solve-eqs, smt
+//   timeout - milliseconds Z3 may spend on one query
+//   capture - directory every query sent to Z3 is written to
+//   cache   - directory of the on-disk query cache
+//   engine  - paths or bmc, with unroll_bound iterations of every loop for bmc
+//   portfolio, portfolio_threshold - race of tactic configurations on the queries slower than the threshold
+//   path_budget, time_budget, query_budget, memory_budget - limits of an anytime run, 0 for no limit
+//   machine_arithmetic - int as 32-bit bit-vectors and float, double as IEEE floating point
+//   string_theory - char and char* as Z3 strings instead of bytes
+//   merge_states, merge_max_vars, merge_max_size - merging of the states of loop-free functions
+//   models_per_path, recycle_paths, recycle_memory, check_policy, check_batch_size and the loop bounds
+//   and optimization switches named like their SolverOptions fields, as in summarize_loops = false
+// Any other name is a Z3 parameter. The tactics and parameters are checked against Z3, and
+// invalid lines are reported and skipped. Returns false if the file is missing or has invalid lines
+bool SolverOptions::load(const std::string& fileName)
 {
-    expr stmntExpr = ADD(line, currIndex, currType);
-    switch (currType)
+    std::ifstream file(fileName);
+    if (!file.is_open())
     {
-    case LEX_EQ:
-        stmntExpr = stmntExpr == ADD(line, currIndex, currType);
-        break;
-
-    case LEX_GREATER:
-        stmntExpr = stmntExpr > ADD(line, currIndex, currType);
-        break;
-
-    case LEX_LESS:
-        stmntExpr = stmntExpr < ADD(line, currIndex, currType);
-        break;
-
-    case LEX_GREATER_EQ:
-        stmntExpr = stmntExpr >= ADD(line, currIndex, currType);
-        break;
-
-    case LEX_LESS_EQ:
-        stmntExpr = stmntExpr <= ADD(line, currIndex, currType);
-        break;
-
-    case LEX_NOT_EQ:
-        stmntExpr = stmntExpr != ADD(line, currIndex, currType);
-        break;
-
-    default:
-        break;
+        std::cout << "ERROR: could not open file " << fileName << "\n";
+        return false;
     }
-    return stmntExpr;
-}
-
-expr Solver::ADD(const std::vector<Token>& line, int& currIndex, lexeme& currType)
-{
-    expr addExpr = MULTI(line, currIndex, currType);
-    while (currType == LEX_PLUS || currType == LEX_MINUS)
+    // Switches of the optimizations, and counts that must be positive
+    const std::map<std::string, bool SolverOptions::*> switches = {
+        { "summarize_loops", &SolverOptions::summarizeLoops }, { "slice_constraints", &SolverOptions::sliceConstraints },
+        { "cache_queries", &SolverOptions::cacheQueries }, { "presolve", &SolverOptions::presolve },
+        { "interval_analysis", &SolverOptions::intervalAnalysis }, { "static_slicing", &SolverOptions::staticSlicing },
+        { "warmup_context", &SolverOptions::warmupContext }, { "prune_by_cores", &SolverOptions::pruneByCores } };
+    const std::map<std::string, int SolverOptions::*> counts = {
+        { "unroll_bound", &SolverOptions::unrollBound }, { "loop_visits", &SolverOptions::loopVisits },
+        { "initial_loop_bound", &SolverOptions::initialLoopBound }, { "loop_bound_growth", &SolverOptions::loopBoundGrowth },
+        { "check_batch_size", &SolverOptions::checkBatchSize } };
+    context ctx;
+    bool isValid = true;
+    std::string line;
+    int lineNum = 0;
+    while (std::getline(file, line))
     {
-        switch (currType)
+        lineNum++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
         {
-        case LEX_PLUS:
-            addExpr = addExpr + MULTI(line, currIndex, currType);
-            break;
-
-        case LEX_MINUS:
-            addExpr = addExpr - MULTI(line, currIndex, currType);
-            break;
-
-        default:
-            break;
+            continue;
         }
-    }
-    return addExpr;
-}
+        size_t separator = line.find('=');
+        std::string name = trim(line.substr(0, separator));
+        std::string value = separator == std::string::npos ? "" : trim(line.substr(separator + 1));
+        std::string error;
+        if (name.empty() || value.empty())
+        {
+            error = "expected name = value";
+        }
+        else if (name == "preset")
+        {
+            if (!applyPreset(value))
+            {
+                error = "unknown preset '" + value + "'";
+            }
+        }
+        else if (name == "tactics")
+        {
+            std::vector<std::string> pipeline;
+            std::stringstream names(value);
+            std::string tacticName;
+            while (error.empty() && std::getline(names, tacticName, ','))
+            {
+                pipeline.push_back(trim(tacticName));
+                try
+                {
+                    tactic(ctx, pipeline.back().c_str());
+                }
+                catch (z3::exception&)
+                {
+                    error = "unknown tactic '" + pipeline.back() + "'";
+                }
+            }
+            if (error.empty())
+            {
+                tactics = pipeline;
+            }
+        }
+        else if (name == "capture")
+        {
+            captureDirectory = value;
+        }
+        else if (name == "cache")
+        {
+            cacheDirectory = value;
+        }
+        else if (name == "timeout")
+        {
+            if (std::all_of(value.begin(), value.end(), ::isdigit))
+            {
+                queryTimeout = std::stoul(value);
+            }
+            else
+            {
+                error = "timeout must be a number of milliseconds";
+            }
+        }
+        else if (name == "portfolio")
+        {
+            if (!parseFlag(value, portfolio))
+            {
+                error = "portfolio must be true or false";
+            }
+        }
+        else if (name == "portfolio_threshold")
+        {
+            int count = 0;
+            if (parseCount(value, count))
+            {
+                portfolioThreshold = count;
+            }
+            else
+            {
+                error = "portfolio_threshold must be a number of milliseconds";
+            }
+        }
+        else if (name == "models_per_path")
+        {
+            if (std::all_of(value.begin(), value.end(), ::isdigit) && std::stoi(value) > 0)
+            {
+                modelsPerPath = std::stoi(value);
+            }
+            else
+            {
+                error = "models_per_path must be a positive number";
+            }
+        }
+        else if (name == "recycle_paths" || name == "recycle_memory")
+        {
+            if (std::all_of(value.begin(), value.end(), ::isdigit))
+            {
+                (name == "recycle_paths" ? recyclePaths : recycleMemory) = std::stoi(value);
+            }
+            else
+            {
+                error = name + " must be a number";
+            }
+        }
+        else if (name == "engine")
+        {
+            if (value == "paths" || value == "bmc")
+            {
+                engine = value == "bmc" ? ENGINE_BMC : ENGINE_PATHS;
+            }
+            else
+            {
+                error = "engine must be paths or bmc";
+            }
+        }
+        else if (name == "check_policy")
+        {
+            if (value == "every_node" || value == "on_constraint" || value == "batched")
+            {
+                policy = value == "every_node" ? CHECK_EVERY_NODE : value == "batched" ? CHECK_BATCHED : CHECK_ON_CONSTRAINT;
+            }
+            else
+            {
+                error = "check_policy must be every_node, on_constraint or batched";
+            }
+        }
+        else if (switches.count(name))
+        {
+            if (!parseFlag(value, this->*switches.at(name)))
+            {
+                error = name + " must be true or false";
+            }
+        }
+        else if (counts.count(name))
+        {
+            int count = 0;
+            if (parseCount(value, count) && count > 0)
+            {
+                this->*counts.at(name) = count;
+            }
+            else
+            {
+                error = name + " must be a positive number";
+            }
+        }
+        else if (name == "path_budget" || name == "time_budget" || name == "query_budget" || name == "memory_budget")
+        {
+            int count = 0;
+            if (!parseCount(value, count))
+            {
+                error = name + " must be a number";
+            }
+            else if (name == "time_budget")
+            {
+                timeBudget = count;
+            }
+            else
+            {
+                (name == "path_budget" ? pathBudget : name == "query_budget" ? queryBudget : memoryBudget) = count;
+            }
+        }
+        else if (name == "machine_arithmetic")
+        {
+            if (!parseFlag(value, machineArithmetic))
+            {
+                error = "machine_arithmetic must be true or false";
+            }
+        }
+        else if (name == "string_theory")
+        {
+            if (!parseFlag(value, stringTheory))
+            {
+                error = "string_theory must be true or false";
+            }
+        }
+        else if (name == "merge_states")
+        {
+            if (!parseFlag(value, mergeStates))
+            {
+                error = "merge_states must be true or false";
+            }
+        }
+        else if (name == "merge_max_vars" || name == "merge_max_size")
+        {
+            int count = 0;
+            if (parseCount(value, count) && count > 0)
+            {
+                (name == "merge_max_vars" ? mergeMaxVars : mergeMaxSize) = count;
+            }
+            else
+            {
+                error = name + " must be a positive number";
+            }
+        }
+        else
+        {
+            // Z3 checks the parameters of a solver when it is first used
+            try
+            {
+                solver validator(ctx);
+                params p(ctx);
+                setParam(p, name, value);
+                validator.set(p);
+                validator.check();
+                z3Params.push_back(std::make_pair(name, value));
+            }
+            catch (z3::exception&)
+            {
+                error = "unknown option or invalid Z3 parameter '" + name + " = " + value + "'";
+            }
+        }
+        if (!error.empty())
+        {
+            std::cout << fileName << ":" << lineNum << ": Error: " << error << "\n";
+            isValid = false;
+        }
+    }
+    return isValid;
+}
+
+// Create a solver from the tactic pipeline, with the Z3 parameters and the query timeout. Goals the pipeline
+// fails on fall back to the smt tactic, so a pipeline that does not fit the theory costs time, not answers
+solver SolverOptions::createSolver(context& ctx) const
+{
+    solver created(ctx);
+    if (!tactics.empty())
+    {
+        tactic pipeline(ctx, tactics.front().c_str());
+        for (int i = 1; i < tactics.size(); i++)
+        {
+            pipeline = pipeline & tactic(ctx, tactics.at(i).c_str());
+        }
+        created = (pipeline | tactic(ctx, "smt")).mk_solver();
+    }
+    params p(ctx);
+    if (queryTimeout > 0)
+    {
+        p.set("timeout", queryTimeout);
+    }
+    for (auto& param : z3Params)
+    {
+        setParam(p, param.first, param.second);
+    }
+    created.set(p);
+    return created;
+}
+
+// Constructor
+SolverStats::SolverStats()
+{
+    checkCalls = 0;
+    checksSaved = 0;
+    loopsSummarized = 0;
+    loopsUnrolled = 0;
+    constraintsSent = 0;
+    constraintsSliced = 0;
+    cacheHits = 0;
+    diskCacheHits = 0;
+    cacheMisses = 0;
+    queriesPresolved = 0;
+    queriesSent = 0;
+    queriesUnknown = 0;
+    portfolioRaces = 0;
+    queriesCaptured = 0;
+    coresRecorded = 0;
+    pathsPruned = 0;
+    pathsSkipped = 0;
+    statesMerged = 0;
+    unrolledNodes = 0;
+    deadEdges = 0;
+    deadNodes = 0;
+    analysisTime = 0;
+    statementsSliced = 0;
+    assignmentsSliced = 0;
+    extraModels = 0;
+    contextsRecycled = 0;
+    recycleTime = 0;
+}
+
+
+//.........................CHECKPOINT
+
+// Constructor
+Checkpoint::Checkpoint(int nodeIndex, int horizon, PersistentStore vars, expr returnVal, std::set<int> loopsAtBound) :
+    nodeIndex(nodeIndex), horizon(horizon), vars(vars), returnVal(returnVal), loopsAtBound(loopsAtBound) {}
+
+
+//.........................MERGED STATE
+
+// Constructor
+MergedState::MergedState(expr condition, PersistentStore vars) : condition(condition), vars(vars) {}
+
+
+//.........................UNROLLED NODE
+
+// Constructor
+UnrolledNode::UnrolledNode(int nodeId, std::map<int, int> loopIters) : nodeId(nodeId), loopIters(loopIters) {}
+
+
+//.........................EXPRESSION TEMPLATE
+
+// Constructor
+ExprTemplate::ExprTemplate(context& ctx) : value(ctx.bool_val(true)) {}
+
+
+//.........................LOOP SUMMARY
+
+// Constructor
+LoopSummary::LoopSummary(context& ctx) : closedForm(ctx)
+{
+    summarized = false;
+}
+
+
+//.........................BYTE STRINGS
+
+// Check whether the sort is the bit-vector of a char* value
+bool isByteString(const z3::sort& s)
+{
+    return s.is_bv() && s.bv_size() == CHAR_BITS * STRING_MAX_LENGTH;
+}
+
+// Get byte of a char* value by its index
+expr getByte(const expr& str, int index)
+{
+    return str.extract(index * CHAR_BITS + CHAR_BITS - 1, index * CHAR_BITS);
+}
+
+// Compare char* values as strcmp does: bytes after the terminating zero do not matter
+expr byteStringEquals(const expr& a, const expr& b)
+{
+    context& ctx = a.ctx();
+    expr result = ctx.bool_val(true);
+    expr live = ctx.bool_val(true);                     // No terminating zero before the current byte
+    for (int i = 0; i < STRING_MAX_LENGTH; i++)
+    {
+        expr byteA = getByte(a, i);
+        result = result && implies(live, byteA == getByte(b, i));
+        live = live && byteA != 0;
+    }
+    return result;
+}
+
+// Concatenate char* values: the bytes of the second one start at the terminating zero of the first one
+expr byteStringConcat(const expr& a, const expr& b)
+{
+    context& ctx = a.ctx();
+    std::vector<expr> endsAt;                           // Terminating zero of the first value is at the index
+    expr live = ctx.bool_val(true);
+    for (int i = 0; i < STRING_MAX_LENGTH; i++)
+    {
+        endsAt.push_back(live && getByte(a, i) == 0);
+        live = live && getByte(a, i) != 0;
+    }
+    expr_vector bytes(ctx);
+    for (int k = STRING_MAX_LENGTH - 1; k >= 0; k--)
+    {
+        expr byte = getByte(a, k);
+        for (int j = k; j >= 0; j--)
+        {
+            byte = ite(endsAt.at(j), getByte(b, k - j), byte);
+        }
+        bytes.push_back(byte);
+    }
+    return concat(bytes);
+}
+
+
+//.........................MACHINE ARITHMETIC
+
+// Bring operands to a common sort as the usual arithmetic conversions of C do:
+// integers to floating point, narrower to wider. Mathematical sorts are left to Z3
+void unifySorts(expr& a, expr& b)
+{
+    if (eq(a.get_sort(), b.get_sort()))
+    {
+        return;
+    }
+    if (a.is_bv() && (b.is_int() || b.is_real()))
+    {
+        a = bv2int(a, true);
+    }
+    else if ((a.is_int() || a.is_real()) && b.is_bv())
+    {
+        b = bv2int(b, true);
+    }
+    else if (a.is_bv() && b.is_fpa())
+    {
+        a = sbv_to_fpa(a, b.get_sort());
+    }
+    else if (a.is_fpa() && b.is_bv())
+    {
+        b = sbv_to_fpa(b, a.get_sort());
+    }
+    else if (a.is_fpa() && b.is_fpa())
+    {
+        if (a.get_sort().fpa_sbits() < b.get_sort().fpa_sbits())
+        {
+            a = fpa_to_fpa(a, b.get_sort());
+        }
+        else
+        {
+            b = fpa_to_fpa(b, a.get_sort());
+        }
+    }
+    else if (a.is_bv() && b.is_bv())
+    {
+        int diff = a.get_sort().bv_size() - b.get_sort().bv_size();
+        if (diff < 0)
+        {
+            a = sext(a, -diff);
+        }
+        else
+        {
+            b = sext(b, diff);
+        }
+    }
+}
+
+// Convert value to the sort of the variable it is assigned to. Floating point is truncated toward zero
+expr castTo(const expr& value, const z3::sort& target)
+{
+    if (eq(value.get_sort(), target))
+    {
+        return value;
+    }
+    if (target.is_fpa() && value.is_bv())
+    {
+        return sbv_to_fpa(value, target);
+    }
+    if (target.is_fpa() && value.is_fpa())
+    {
+        return fpa_to_fpa(value, target);
+    }
+    if (target.is_bv() && value.is_fpa())
+    {
+        context& ctx = value.ctx();
+        return expr(ctx, Z3_mk_fpa_to_sbv(ctx, Z3_mk_fpa_rtz(ctx), value, target.bv_size()));
+    }
+    if (target.is_bv() && value.is_bv())
+    {
+        int diff = target.bv_size() - value.get_sort().bv_size();
+        return diff > 0 ? sext(value, diff) : value.extract(target.bv_size() - 1, 0);
+    }
+    if (target.is_bv() && value.is_int())
+    {
+        return int2bv(target.bv_size(), value);
+    }
+    if (target.is_bv() && value.is_real())
+    {
+        context& ctx = value.ctx();
+        expr floor = expr(ctx, Z3_mk_real2int(ctx, value));
+        expr ceiling = -expr(ctx, Z3_mk_real2int(ctx, -value));
+        return int2bv(target.bv_size(), ite(value >= 0, floor, ceiling));
+    }
+    if (target.is_int() && value.is_bv())
+    {
+        return bv2int(value, true);
+    }
+    if (target.is_real() && value.is_bv())
+    {
+        return to_real(bv2int(value, true));
+    }
+    return value;
+}
+
+// Promote char operand of arithmetic to int as C does
+expr promote(const expr& value)
+{
+    if (value.is_bv() && value.get_sort().bv_size() < INT_BITS)
+    {
+        return sext(value, INT_BITS - value.get_sort().bv_size());
+    }
+    return value;
+}
+
+// Apply arithmetic operator. Bit-vectors wrap around on overflow, divide truncating toward zero
+// and take the sign of the dividend for the remainder, like int in C
+expr applyArithmetic(lexeme op, expr a, expr b)
+{
+    if (isByteString(a.get_sort()))
+    {
+        return byteStringConcat(a, b);
+    }
+    a = promote(a);
+    b = promote(b);
+    unifySorts(a, b);
+    switch (op)
+    {
+    case LEX_PLUS: case LEX_PLUS_ASSIGN:
+        return a + b;
+
+    case LEX_MINUS: case LEX_MINUS_ASSIGN:
+        return a - b;
+
+    case LEX_TIMES: case LEX_TIMES_ASSIGN:
+        return a * b;
+
+    case LEX_SLASH: case LEX_SLASH_ASSIGN:
+        return a / b;
+
+    default:
+        return a.is_bv() ? srem(a, b) : a % b;
+    }
+}
+
+// Apply comparison operator. Floating-point equality follows IEEE 754 as in C
+expr applyComparison(lexeme op, expr a, expr b)
+{
+    if (isByteString(a.get_sort()))
+    {
+        return op == LEX_EQ ? byteStringEquals(a, b) : !byteStringEquals(a, b);
+    }
+    if (a.is_seq() && op >= LEX_GREATER && op <= LEX_LESS_EQ)
+    {
+        context& ctx = a.ctx();
+        switch (op)
+        {
+        case LEX_GREATER:
+            return expr(ctx, Z3_mk_str_lt(ctx, b, a));
+
+        case LEX_LESS:
+            return expr(ctx, Z3_mk_str_lt(ctx, a, b));
+
+        case LEX_GREATER_EQ:
+            return expr(ctx, Z3_mk_str_le(ctx, b, a));
+
+        default:
+            return expr(ctx, Z3_mk_str_le(ctx, a, b));
+        }
+    }
+    unifySorts(a, b);
+    switch (op)
+    {
+    case LEX_EQ:
+        return a.is_fpa() ? fp_eq(a, b) : a == b;
+
+    case LEX_NOT_EQ:
+        return a.is_fpa() ? !fp_eq(a, b) : a != b;
+
+    case LEX_GREATER:
+        return a > b;
+
+    case LEX_LESS:
+        return a < b;
+
+    case LEX_GREATER_EQ:
+        return a >= b;
+
+    default:
+        return a <= b;
+    }
+}
+
+// Print byte as it is spelled in C character and string literals
+std::string formatByte(unsigned byte)
+{
+    switch (byte)
+    {
+    case '\0':
+        return "\\0";
+
+    case '\n':
+        return "\\n";
+
+    case '\t':
+        return "\\t";
+
+    case '\r':
+        return "\\r";
+
+    case '\\': case '\'': case '"':
+        return "\\" + std::string(1, (char) byte);
+
+    default:
+        break;
+    }
+    if (isprint(byte))
+    {
+        return std::string(1, (char) byte);
+    }
+    char escaped[8];
+    snprintf(escaped, sizeof(escaped), "\\x%02x", byte);
+    return escaped;
+}
+
+// Print value of a model: bit-vectors as signed integers, bytes as characters
+// and floating point in decimal, as C would
+std::string formatValue(const expr& value)
+{
+    if (value.is_bv() && value.is_numeral() && value.get_sort().bv_size() == CHAR_BITS)
+    {
+        return "'" + formatByte(value.get_numeral_uint()) + "'";
+    }
+    if (value.is_bv() && value.is_numeral() && isByteString(value.get_sort()))
+    {
+        std::string text;
+        for (int i = 0; i < STRING_MAX_LENGTH; i++)
+        {
+            unsigned byte = getByte(value, i).simplify().get_numeral_uint();
+            if (byte == 0)
+            {
+                break;
+            }
+            text += formatByte(byte);
+        }
+        return "\"" + text + "\"";
+    }
+    if (value.is_bv() && value.is_numeral())
+    {
+        unsigned size = value.get_sort().bv_size();
+        uint64_t bits = value.get_numeral_uint64();
+        int64_t signedValue = size < 64 && (bits >> (size - 1) & 1) ? (int64_t) (bits - (1ULL << size)) : (int64_t) bits;
+        return std::to_string(signedValue);
+    }
+    if (value.is_fpa())
+    {
+        if (value.mk_is_nan().simplify().is_true())
+        {
+            return "NaN";
+        }
+        if (value.mk_is_inf().simplify().is_true())
+        {
+            return (value < 0).simplify().is_true() ? "-inf" : "inf";
+        }
+        expr real = expr(value.ctx(), Z3_mk_fpa_to_real(value.ctx(), value)).simplify();
+        if (real.is_numeral())
+        {
+            return real.get_decimal_string(DECIMAL_DIGITS);
+        }
+    }
+    return value.to_string();
+}
+
+
+//.........................TEST SUITE STORE CLASS
+
+// Constructor of an empty column
+TestSuiteStore::Column::Column(valueKind kind) : kind(kind) {}
+
+// Constructor. The input columns take their kinds from the sorts of the input variables
+TestSuiteStore::TestSuiteStore(std::vector<Identifier> inputs, const std::vector<z3::sort>& sorts) : inputs(inputs)
+{
+    for (auto& s : sorts)
+    {
+        columns.push_back(Column(getKind(s)));
+    }
+    columns.push_back(Column(VALUE_NONE));
+}
+
+// Kind of the values of the sort, in the order formatValue tells them apart
+valueKind TestSuiteStore::getKind(const z3::sort& s)
+{
+    if (s.is_bv() && s.bv_size() == CHAR_BITS)
+    {
+        return VALUE_CHAR;
+    }
+    if (isByteString(s))
+    {
+        return VALUE_BYTES;
+    }
+    if (s.is_bv())
+    {
+        return s.bv_size() <= 64 ? VALUE_BITS : VALUE_TEXT;
+    }
+    if (s.is_fpa())
+    {
+        unsigned ebits = Z3_fpa_get_ebits(s.ctx(), s);
+        unsigned sbits = Z3_fpa_get_sbits(s.ctx(), s);
+        bool isNative = (ebits == FLOAT_EBITS && sbits == FLOAT_SBITS) || (ebits == DOUBLE_EBITS && sbits == DOUBLE_SBITS);
+        return isNative ? VALUE_FLOAT : VALUE_TEXT;
+    }
+    if (s.is_int())
+    {
+        return VALUE_INT;
+    }
+    if (s.is_real())
+    {
+        return VALUE_RATIONAL;
+    }
+    if (s.is_bool())
+    {
+        return VALUE_BOOL;
+    }
+    return VALUE_TEXT;
+}
+
+// Add a slot to the typed vectors of the kind of the column
+void TestSuiteStore::push(Column& column, int64_t number, int64_t denominator, double floating, const std::string& text)
+{
+    switch (column.kind)
+    {
+    case VALUE_RATIONAL:
+        column.numbers.push_back(number);
+        column.denominators.push_back(denominator);
+        break;
+
+    case VALUE_FLOAT:
+        column.floats.push_back(floating);
+        break;
+
+    case VALUE_BYTES: case VALUE_TEXT:
+        column.texts.push_back(text);
+        break;
+
+    default:
+        column.numbers.push_back(number);
+        break;
+    }
+}
+
+// Add the value to the column in the row. A value that is not a numeral of the kind of the
+// column is kept formatted, and its slot in the typed vectors is left zero
+void TestSuiteStore::append(Column& column, const expr& value, int row)
+{
+    if (column.kind == VALUE_NONE)
+    {
+        column.kind = getKind(value.get_sort());
+    }
+    bool fits = getKind(value.get_sort()) == column.kind && (value.is_numeral() || column.kind == VALUE_BOOL || column.kind == VALUE_TEXT);
+    int64_t number = 0;
+    int64_t denominator = 1;
+    double floating = 0;
+    std::string text;
+    if (fits)
+    {
+        switch (column.kind)
+        {
+        case VALUE_INT:
+            fits = value.is_numeral_i64(number);
+            break;
+
+        case VALUE_BITS:
+        {
+            unsigned size = value.get_sort().bv_size();
+            uint64_t bits = value.get_numeral_uint64();
+            number = size < 64 && (bits >> (size - 1) & 1) ? (int64_t) (bits - (1ULL << size)) : (int64_t) bits;
+            break;
+        }
+
+        case VALUE_RATIONAL:
+            fits = value.numerator().is_numeral_i64(number) && value.denominator().is_numeral_i64(denominator);
+            break;
+
+        case VALUE_FLOAT:
+            if (value.mk_is_nan().simplify().is_true())
+            {
+                floating = NAN;
+            }
+            else
+            {
+                // The IEEE bits of the value are the bits of the C float or double
+                uint64_t bits = expr(value.ctx(), Z3_mk_fpa_to_ieee_bv(value.ctx(), value)).simplify().get_numeral_uint64();
+                if (Z3_fpa_get_sbits(value.ctx(), value.get_sort()) == DOUBLE_SBITS)
+                {
+                    memcpy(&floating, &bits, sizeof(floating));
+                }
+                else
+                {
+                    uint32_t singleBits = (uint32_t) bits;
+                    float single;
+                    memcpy(&single, &singleBits, sizeof(single));
+                    floating = single;
+                }
+            }
+            break;
+
+        case VALUE_BOOL:
+            fits = value.is_true() || value.is_false();
+            number = value.is_true() ? 1 : 0;
+            break;
+
+        case VALUE_CHAR:
+            number = value.get_numeral_uint();
+            break;
+
+        case VALUE_BYTES:
+            for (int i = 0; i < STRING_MAX_LENGTH; i++)
+            {
+                unsigned byte = getByte(value, i).simplify().get_numeral_uint();
+                if (byte == 0)
+                {
+                    break;
+                }
+                text += (char) byte;
+            }
+            break;
+
+        default:
+            text = value.to_string();
+            break;
+        }
+    }
+    if (fits)
+    {
+        push(column, number, denominator, floating, text);
+    }
+    else
+    {
+        column.irregular[row] = formatValue(value);
+        push(column, 0, 1, 0, "");
+    }
+}
+
+// Print integer as Z3 prints integer numerals
+std::string formatInteger(int64_t value)
+{
+    return value < 0 ? "(- " + std::to_string(0 - (uint64_t) value) + ")" : std::to_string(value);
+}
+
+// Print floating-point value in decimal as Z3 prints its exact real value: at most DECIMAL_DIGITS
+// fraction digits, and a '?' if more were cut off
+std::string formatDecimal(double value)
+{
+    if (std::isnan(value))
+    {
+        return "NaN";
+    }
+    if (std::isinf(value))
+    {
+        return value < 0 ? "-inf" : "inf";
+    }
+    char digits[1500];                                  // The exact expansion of a double has at most 1074 fraction digits
+    snprintf(digits, sizeof(digits), "%.1080f", std::fabs(value));
+    std::string text = digits;
+    size_t point = text.find('.');
+    std::string integral = text.substr(0, point);
+    std::string fraction = text.substr(point + 1);
+    fraction.erase(fraction.find_last_not_of('0') + 1);
+    bool truncated = fraction.size() > DECIMAL_DIGITS;
+    if (truncated)
+    {
+        fraction.resize(DECIMAL_DIGITS);
+    }
+    bool isZero = integral == "0" && fraction.find_first_not_of('0') == std::string::npos && !truncated;
+    std::string sign = value < 0 && !isZero ? "-" : "";
+    return sign + integral + (fraction.empty() ? "" : "." + fraction) + (truncated ? "?" : "");
+}
+
+// Print the value of the column in the row as formatValue prints the Z3 value
+std::string TestSuiteStore::format(const Column& column, int row) const
+{
+    auto it = column.irregular.find(row);
+    if (it != column.irregular.end())
+    {
+        return it->second;
+    }
+    switch (column.kind)
+    {
+    case VALUE_INT:
+        return formatInteger(column.numbers.at(row));
+
+    case VALUE_BITS:
+        return std::to_string(column.numbers.at(row));
+
+    case VALUE_RATIONAL:
+    {
+        int64_t numerator = column.numbers.at(row);
+        int64_t denominator = column.denominators.at(row);
+        std::string magnitude = std::to_string(numerator < 0 ? 0 - (uint64_t) numerator : (uint64_t) numerator) + ".0";
+        if (denominator != 1)
+        {
+            magnitude = "(/ " + magnitude + " " + std::to_string(denominator) + ".0)";
+        }
+        return numerator < 0 ? "(- " + magnitude + ")" : magnitude;
+    }
+
+    case VALUE_FLOAT:
+        return formatDecimal(column.floats.at(row));
+
+    case VALUE_BOOL:
+        return column.numbers.at(row) ? "true" : "false";
+
+    case VALUE_CHAR:
+        return "'" + formatByte((unsigned) column.numbers.at(row)) + "'";
+
+    case VALUE_BYTES:
+    {
+        std::string text;
+        for (auto& byte : column.texts.at(row))
+        {
+            text += formatByte((unsigned char) byte);
+        }
+        return "\"" + text + "\"";
+    }
+
+    default:
+        return column.texts.at(row);
+    }
+}
+
+// Add a row of the input values and the output. An empty vector of inputs means any inputs
+int TestSuiteStore::addRow(const expr_vector& inputValues, const expr& output)
+{
+    int row = unspecified.size();
+    bool isUnspecified = inputValues.size() == 0;
+    for (int i = 0; i < inputs.size(); i++)
+    {
+        if (isUnspecified)
+        {
+            push(columns.at(i), 0, 1, 0, "");           // Keeps the rows of the columns aligned
+        }
+        else
+        {
+            append(columns.at(i), inputValues[i], row);
+        }
+    }
+    append(columns.back(), output, row);
+    unspecified.push_back(isUnspecified);
+    return row;
+}
+
+int TestSuiteStore::getInputCount() const
+{
+    return inputs.size();
+}
+
+const Identifier& TestSuiteStore::getInput(int index) const
+{
+    return inputs.at(index);
+}
+
+// Get the printed value of the input variable in the row
+std::string TestSuiteStore::getValue(int row, int index) const
+{
+    return unspecified.at(row) ? "Any value" : format(columns.at(index), row);
+}
+
+// Get the printed output in the row
+std::string TestSuiteStore::getOutput(int row) const
+{
+    return format(columns.back(), row);
+}
+
+
+//.........................TEST CASE CLASS
+
+// Constructor for infeasible test case
+TestCase::TestCase()
+{
+    sat = false;
+    row = -1;
+    variantCount = 0;
+}
+
+// Constructor for feasible test case
+TestCase::TestCase(std::shared_ptr<TestSuiteStore> store, expr_vector evals, expr returnVal) : store(store)
+{
+    sat = true;
+    row = store->addRow(evals, returnVal.simplify());
+    variantCount = 0;
+}
+
+// Add other inputs of the same path with the output they give. They must be added before the next test case
+void TestCase::addVariant(expr_vector evals, expr returnVal)
+{
+    store->addRow(evals, returnVal.simplify());
+    variantCount++;
+}
+
+// Get test case feasibility
+bool TestCase::isFeasible()
+{
+    return sat;
+}
+
+// Get number of input variables
+int TestCase::getSize()
+{
+    return sat ? store->getInputCount() : 0;
+}
+
+// Get identifier
+Identifier TestCase::getId(int index)
+{
+    return store->getInput(index);
+}
+
+// Get value of the identifier
+string TestCase::getIdValue(int index)
+{
+    return store->getValue(row, index);
+}
+
+// Get the function output
+string TestCase::getOutput()
+{
+    return sat ? store->getOutput(row) : "";
+}
+
+// Get number of other inputs taking the same path
+int TestCase::getVariantCount()
+{
+    return variantCount;
+}
+
+// Get value of the identifier in the other input
+string TestCase::getVariantValue(int variant, int index)
+{
+    return store->getValue(row + 1 + variant, index);
+}
+
+// Get the function output for the other input
+string TestCase::getVariantOutput(int variant)
+{
+    return store->getOutput(row + 1 + variant);
+}
+
+
+//.........................SMT SOLVER CLASS
+// Collect paths from the node, visiting the header of each loop at most options.loopVisits times
+void Solver::collectPaths(int id, Path currPath, std::set<int> visitedNodes, std::map<int, int> loopVisits)
+{
+    Node& node = cfg.nodes[id];
+    currPath.push_back(node);
+    visitedNodes.insert(id);
+
+    if (node.edges.empty())
+    {
+        paths.push_back(currPath);
+    }
+    else
+    {
+        Token branch = node.code.front();
+        int loopIterCount = 0;
+        if (branch.getLexeme() == LEX_WHILE || branch.getLexeme() == LEX_FOR)
+        {
+            loopIterCount = ++loopVisits[id];
+        }
+
+        if (node.edges.size() == 1 && !node.edges.front().condition.empty())
+        {
+            paths.push_back(currPath);
+            if (!isDeadEdge(id, 0))
+            {
+                collectPaths(node.edges.front().idTarget, currPath, visitedNodes, loopVisits);
+            }
+        }
+        else
+        {
+            for (int edgeIndex = 0; edgeIndex < node.edges.size(); edgeIndex++)
+            {
+                const Edge& edge = node.edges.at(edgeIndex);
+                //if (visitedNodes.count(edge.idTarget) == 0 || edge.condition.empty())
+                if ((loopIterCount <= options.loopVisits || edge.condition.empty()) && !isDeadEdge(id, edgeIndex))
+                {
+                    collectPaths(edge.idTarget, currPath, visitedNodes, loopVisits);
+                }
+            }
+        }
+    }
+}
+
+Token Solver::getLexeme(const std::vector<Token>& line, int& index, lexeme& type)
+{
+    if (index >= line.size())
+    {
+        return Token(LEX_FIN, LEX_FIN);
+    }
+    int i = index;
+    type = line.at(i).getLexeme();
+    index++;
+    return line.at(i);
+}
+
+void Solver::ungetLexeme(const std::vector<Token>& line, int& index, lexeme& type)
+{
+    if (index > 0)
+    {
+        index--;
+        type = line.at(index).getLexeme();
+    }
+}
+
+void Solver::solveStatement(const std::vector<Token>& code)
+{
+    // reset index to start parsing codeline from the first token
+    int index = 0;
+	lexeme type = LEX_NULL;
+    
+    auto codeIt = std::find_if(
+        code.begin(),
+        code.end(),
+        [](Token lex)
+        {
+            return (
+                lex.getLexeme() == LEX_ASSIGN ||
+                lex.getLexeme() >= LEX_INT && lex.getLexeme() <= LEX_STRING ||
+                lex.getLexeme() >= LEX_PLUS_ASSIGN && lex.getLexeme() <= LEX_SLASH_ASSIGN
+            );
+        }
+    );
+    if (codeIt != code.end())
+    {
+        solveAssign(code, index, type);
+    }
+    else
+    {
+        EXPR(code, index, type);
+    }
+}
+
+void Solver::solveAssign(const std::vector<Token>& code, int& index, lexeme& type)
+{
+    Token lex = getLexeme(code, index, type);
+    lexeme idType = LEX_NULL;
+    if (type >= LEX_INT && type <= LEX_STRING)
+    {
+        idType = type;
+        lex = getLexeme(code, index, type);
+    }
+    if (type == LEX_ID)
+    {
+        int idVal = lex.getValue();
+        getLexeme(code, index, type);
+        expr assignExpr = sym.getExpr(idVal);
+        switch (type)
+        {
+        case LEX_ASSIGN:
+            sym.setExpr(idVal, castTo(EXPR(code, index, type), assignExpr.get_sort()));
+            break;
+
+        case LEX_PLUS_ASSIGN: case LEX_MINUS_ASSIGN: case LEX_TIMES_ASSIGN: case LEX_SLASH_ASSIGN:
+        {
+            lexeme op = type;
+            expr value = applyArithmetic(op, sym.getExpr(idVal), EXPR(code, index, type));
+            sym.setExpr(idVal, castTo(value, assignExpr.get_sort()));
+            break;
+        }
+
+        default:
+            switch (idType)
+            {
+            case LEX_INT: case LEX_FLOAT: case LEX_DOUBLE:
+                sym.setExpr(idVal, sym.ctx->num_val(DEFAULT_NUM_VALUE, assignExpr.get_sort()));
+                break;
+
+            case LEX_CHAR:
+                sym.setExpr(idVal, sym.charVal(DEFAULT_CHAR_VALUE));
+                break;
+            }
+            break;
+        }
+    }
+}
+
+expr Solver::solveCondition(const std::vector<Token>& cnd)
+{
+    int index = 0;
+    lexeme type;
+    expr cndExpr = sym.ctx->bool_val(true); // default
+    getLexeme(cnd, index, type);
+    if (type == LEX_LEFT_PAREN)
+    {
+        cndExpr = EXPR(cnd, index, type);
+    }
+    return cndExpr;
+}
+
+// Open solver scope together with the path condition
+void Solver::pushScope(solver& solver)
+{
+    solver.push();
+    scopeSizes.push_back(pathCondition.getSize());
+}
+
+// Close solver scopes dropping their constraints from the path condition
+void Solver::popScope(solver& solver, int count)
+{
+    solver.pop(count);
+    pathCondition.truncate(scopeSizes.at(scopeSizes.size() - count));
+    scopeSizes.erase(scopeSizes.end() - count, scopeSizes.end());
+}
+
+// Add constraint to the path condition
+void Solver::addConstraint(solver& solver, const expr& constraint, std::pair<int, int> decision)
+{
+    solver.add(constraint);
+    pathCondition.add(constraint.simplify(), sym.getInputIds(constraint), decision);
+    pendingConstraints++;
+}
+
+// Check whether the scheduling policy requires a solver query after the current node
+bool Solver::checkIsDue() const
+{
+    switch (options.policy)
+    {
+    case CHECK_EVERY_NODE:
+        return true;
+
+    case CHECK_BATCHED:
+        return pendingConstraints >= options.checkBatchSize;
+
+    default:
+        return pendingConstraints > 0;
+    }
+}
+
+// Query the solver
+check_result Solver::checkSat(solver& solver)
+{
+    stats.checkCalls++;
+    pendingConstraints = 0;
+    model m(*sym.ctx);
+    check_result result;
+    if (!options.sliceConstraints)
+    {
+        std::vector<int> all(pathCondition.getSize());
+        std::iota(all.begin(), all.end(), 0);
+        result = checkSlice(solver, all, m);
+    }
+    else
+    {
+        // Constraints already checked stay satisfiable unless they share variables with the new ones
+        std::vector<int> slice = pathCondition.getPendingSlice();
+        stats.constraintsSliced += pathCondition.getSize() - slice.size();
+        result = slice.empty() ? sat : checkSlice(solver, slice, m);
+    }
+
+    // A slice that is not known to be satisfiable stays pending, so the next check includes it again
+    if (result == sat)
+    {
+        pathCondition.setCheckedCount(pathCondition.getSize());
+    }
+    return result;
+}
+
+// Query satisfiability of a subset of the path condition, consulting the counterexample cache
+// and the pre-solver first. Without slicing the slice is the whole path condition and goes to the incremental solver
+check_result Solver::checkSlice(solver& solver, const std::vector<int>& slice, model& m)
+{
+    std::vector<expr> query;
+    for (auto& index : slice)
+    {
+        query.push_back(pathCondition.get(index));
+    }
+    if (options.cacheQueries)
+    {
+        check_result cached = queryCache.lookup(query, m);
+        if (cached != unknown)
+        {
+            stats.cacheHits++;
+            return cached;
+        }
+    }
+    if (diskCache.isEnabled())
+    {
+        check_result stored = diskCache.lookup(query, m);
+        if (stored != unknown)
+        {
+            stats.diskCacheHits++;
+            if (options.cacheQueries)
+            {
+                queryCache.insert(query, stored, m);
+            }
+            return stored;
+        }
+    }
+    if (options.cacheQueries || diskCache.isEnabled())
+    {
+        stats.cacheMisses++;
+    }
+    if (options.presolve)
+    {
+        check_result decided = preSolver.check(query, m);
+        if (decided != unknown)
+        {
+            stats.queriesPresolved++;
+            if (options.cacheQueries)
+            {
+                queryCache.insert(query, decided, m);
+            }
+            return decided;
+        }
+    }
+    if (!withinBudget())
+    {
+        queryUnknown = true;
+        stats.queriesUnknown++;
+        return unknown;
+    }
+
+    stats.queriesSent++;
+    stats.constraintsSent += slice.size();
+    check_result result;
+    if (options.sliceConstraints)
+    {
+        sliceSolver.push();
+        for (auto& constraint : query)
+        {
+            sliceSolver.add(constraint);
+        }
+        result = checkWithPortfolio(sliceSolver, expr_vector(*sym.ctx), m);
+        sliceSolver.pop();
+    }
+    else
+    {
+        result = checkWithPortfolio(solver, expr_vector(*sym.ctx), m);
+    }
+    if (result == unknown)
+    {
+        queryUnknown = true;
+        stats.queriesUnknown++;
+    }
+    if (options.cacheQueries)
+    {
+        queryCache.insert(query, result, m);
+    }
+    diskCache.insert(query, result, m);
+    if (result == unsat && options.pruneByCores)
+    {
+        recordUnsatCore(query, slice);
+    }
+    return result;
+}
+
+// Check the assertions of the solver under the assumptions. With the portfolio on, the solver gets
+// a short threshold first, and a query it cannot decide within it is raced on the portfolio.
+// With the capture on, the query is written out with the current path and node, time and result
+check_result Solver::checkWithPortfolio(solver& solver, const expr_vector& assumptions, model& m)
+{
+    auto start = std::chrono::steady_clock::now();
+    bool racing = options.portfolio && options.portfolioThreshold > 0 &&
+        (options.queryTimeout == 0 || options.portfolioThreshold < options.queryTimeout);
+    if (racing)
+    {
+        setTimeout(solver, options.portfolioThreshold);
+    }
+    check_result result = solver.check(assumptions);
+    if (result == sat)
+    {
+        m = solver.get_model();
+    }
+    if (racing)
+    {
+        setTimeout(solver, options.queryTimeout);
+    }
+    if (racing && result == unknown)
+    {
+        std::vector<expr> query;
+        expr_vector asserted = solver.assertions();
+        for (int i = 0; i < asserted.size(); i++)
+        {
+            query.push_back(asserted[i]);
+        }
+        for (int i = 0; i < assumptions.size(); i++)
+        {
+            query.push_back(assumptions[i]);
+        }
+        stats.portfolioRaces++;
+        result = portfolio.check(query, m, options.queryTimeout);
+        if (result != unknown)
+        {
+            stats.portfolioWins[portfolio.getLastWinner()]++;
+        }
+    }
+    if (capture.isEnabled())
+    {
+        double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        capture.write(solver, assumptions, currPathId, currNodeId, time, result);
+        stats.queriesCaptured++;
+    }
+    return result;
+}
+
+// Check whether the expression contains any of the given subexpressions
+bool dependsOn(const expr& e, const std::unordered_set<unsigned>& astIds, std::unordered_set<unsigned>& visited)
+{
+    if (astIds.count(e.id()))
+    {
+        return true;
+    }
+    if (!e.is_app() || !visited.insert(e.id()).second)
+    {
+        return false;
+    }
+    for (int i = 0; i < e.num_args(); i++)
+    {
+        if (dependsOn(e.arg(i), astIds, visited))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Find a minimal conflicting subset of an unsatisfiable query. The subset is cached as unsatisfiable,
+// and if all of it comes from stable branch decisions, the set of their edges is recorded
+void Solver::recordUnsatCore(const std::vector<expr>& query, const std::vector<int>& slice)
+{
+    params p(*sym.ctx);
+    p.set("core.minimize", true);
+    sliceSolver.set(p);
+    sliceSolver.push();
+    expr_vector literals(*sym.ctx);
+    for (int i = 0; i < query.size(); i++)
+    {
+        std::string name = "core!" + std::to_string(i);
+        literals.push_back(sym.ctx->bool_const(name.c_str()));
+        sliceSolver.add(implies(literals.back(), query.at(i)));
+    }
+    bool isUnsat = sliceSolver.check(literals) == unsat;
+    expr_vector core = isUnsat ? sliceSolver.unsat_core() : expr_vector(*sym.ctx);
+    sliceSolver.pop();
+    if (!isUnsat || core.empty())                       // Solvers built from tactics do not produce cores
+    {
+        return;
+    }
+
+    std::vector<expr> coreQuery;
+    std::set<std::pair<int, int>> coreDecisions;
+    bool stable = true;
+    for (int i = 0; i < query.size(); i++)
+    {
+        bool inCore = false;
+        for (int j = 0; j < core.size(); j++)
+        {
+            inCore = inCore || eq(core[j], literals[i]);
+        }
+        if (inCore)
+        {
+            coreQuery.push_back(query.at(i));
+            std::pair<int, int> decision = pathCondition.getDecision(slice.at(i));
+            stable = stable && decision.first >= 0;
+            coreDecisions.insert(decision);
+        }
+    }
+    if (options.cacheQueries)
+    {
+        queryCache.insert(coreQuery, unsat, model(*sym.ctx));
+    }
+    if (stable && std::find(decisionCores.begin(), decisionCores.end(), coreDecisions) == decisionCores.end())
+    {
+        decisionCores.push_back(coreDecisions);
+        stats.coresRecorded++;
+    }
+}
+
+// Find the variables the function assigns and the nodes that can be executed repeatedly
+void Solver::analyzeFlow()
+{
+    flowAnalyzed = true;
+    for (auto& entry : cfg.nodes)
+    {
+        const Node& node = entry.second;
+        std::vector<const ExprTemplate*> nodeTemplates;
+        switch (node.code.front().getLexeme())
+        {
+        case LEX_IF: case LEX_WHILE: case LEX_DO:
+            break;
+
+        case LEX_FOR:
+            nodeTemplates.push_back(&getTemplate(TMPL_FOR_INIT, node));
+            nodeTemplates.push_back(&getTemplate(TMPL_FOR_ITER, node));
+            break;
+
+        case LEX_RETURN:
+            nodeTemplates.push_back(&getTemplate(TMPL_RETURN, node));
+            break;
+
+        default:
+            nodeTemplates.push_back(&getTemplate(TMPL_STATEMENT, node));
+            break;
+        }
+        for (int edgeIndex = 0; edgeIndex < node.edges.size(); edgeIndex++)
+        {
+            if (!node.edges.at(edgeIndex).condition.empty())
+            {
+                nodeTemplates.push_back(&getTemplate(TMPL_CONDITION, node, edgeIndex));
+            }
+        }
+        for (auto& tmpl : nodeTemplates)
+        {
+            for (auto& update : tmpl->updates)
+            {
+                writtenVars.insert(sym.placeholders[sym.varPositions.at(update.first)].id());
+            }
+        }
+
+        // The node is on a cycle if it is reachable from its successors
+        std::vector<int> stack;
+        std::set<int> visited;
+        for (auto& edge : node.edges)
+        {
+            stack.push_back(edge.idTarget);
+        }
+        while (!stack.empty())
+        {
+            int id = stack.back();
+            stack.pop_back();
+            if (id == node.id)
+            {
+                cyclicNodes.insert(node.id);
+                break;
+            }
+            if (visited.insert(id).second && cfg.nodes.count(id))
+            {
+                for (auto& edge : cfg.nodes.at(id).edges)
+                {
+                    stack.push_back(edge.idTarget);
+                }
+            }
+        }
+    }
+}
+
+// Check whether the branch adds the same constraint on every path through it:
+// the node is executed at most once and its condition reads only variables the function never assigns
+bool Solver::isStableDecision(const Node& node, int edgeIndex)
+{
+    if (!flowAnalyzed)
+    {
+        analyzeFlow();
+    }
+    if (cyclicNodes.count(node.id))
+    {
+        return false;
+    }
+    const ExprTemplate& tmpl = getTemplate(TMPL_CONDITION, node, edgeIndex);
+    std::unordered_set<unsigned> written(writtenVars.begin(), writtenVars.end());
+    std::unordered_set<unsigned> visited;
+    return tmpl.updates.empty() && !dependsOn(tmpl.value, written, visited);
+}
+
+// Check whether the path takes all branch edges of a recorded conflicting set
+bool Solver::containsKnownCore(const Path& path)
+{
+    std::set<std::pair<int, int>> pathDecisions;
+    for (int i = 0; i < path.size(); i++)
+    {
+        if (path.at(i).code.front().getLexeme() == LEX_IF)
+        {
+            pathDecisions.insert(std::make_pair(path.at(i).id, i + 1 < path.size() ? path.at(i + 1).id : -1));
+        }
+    }
+    for (auto& core : decisionCores)
+    {
+        if (std::includes(pathDecisions.begin(), pathDecisions.end(), core.begin(), core.end()))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Solve independent clusters of the path condition one by one and merge their models.
+// Variables no constraint reads get the default values of model completion
+bool Solver::solveClusters(solver& solver, model& merged)
+{
+    stats.checkCalls++;
+    pendingConstraints = 0;
+    pathCondition.setCheckedCount(pathCondition.getSize());
+    if (!options.sliceConstraints)
+    {
+        std::vector<int> all(pathCondition.getSize());
+        std::iota(all.begin(), all.end(), 0);
+        if (checkSlice(solver, all, merged) != sat)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        for (auto& cluster : pathCondition.getClusters())
+        {
+            model m(*sym.ctx);
+            if (checkSlice(solver, cluster, m) != sat)
+            {
+                return false;
+            }
+
+            // A cached model may come from a larger query, so only the variables of the cluster are taken
+            std::set<int> clusterVars;
+            for (auto& index : cluster)
+            {
+                clusterVars.insert(pathCondition.getVars(index).begin(), pathCondition.getVars(index).end());
+            }
+            for (auto& idIndex : clusterVars)
+            {
+                expr initVal = sym.initVars.get(idIndex);
+                func_decl decl = initVal.decl();
+                expr value = m.eval(initVal, true);
+                merged.add_const_interp(decl, value);
+            }
+        }
+    }
+
+    return true;
+}
+
+// Get input variables of the function and their identifier IDs
+void Solver::getInputs(std::vector<Identifier>& inputVars, std::vector<int>& inputIndices)
+{
+    for (int idIndex = 0; idIndex < ids.size(); idIndex++)
+    {
+        if (ids.at(idIndex).getIdType() == INPUT_VAR)
+        {
+            inputVars.push_back(ids.at(idIndex));
+            inputIndices.push_back(idIndex);
+        }
+    }
+}
+
+// Evaluate the input variables as they were before executing the path, and the return value.
+// A model without constants leaves the inputs unspecified
+void Solver::evaluateModel(const model& m, const std::vector<int>& inputIndices, expr_vector& inputValues, expr& returnVal)
+{
+    if (m.size() > 0)
+    {
+        for (auto& idIndex : inputIndices)
+        {
+            inputValues.push_back(m.eval(sym.initVars.get(idIndex), true));
+        }
+        returnVal = m.eval(returnVal, true);
+    }
+}
+
+
+// Find up to modelsPerPath - 1 more inputs for the path from the solver that holds its condition.
+// Each one is blocked by a clause requiring the next to differ from it in some input, so every
+// input costs one more check. The clauses live in a scope of their own, dropped at the end
+void Solver::findVariants(TestCase& testCase, solver& solver, const model& m, const std::vector<int>& inputIndices, const expr& returnVal)
+{
+    if (options.modelsPerPath <= 1 || inputIndices.empty())
+    {
+        return;
+    }
+    solver.push();
+    model last = m;
+    for (int k = 1; k < options.modelsPerPath && withinBudget(); k++)
+    {
+        expr_vector differs(*sym.ctx);
+        for (auto& idIndex : inputIndices)
+        {
+            expr input = sym.initVars.get(idIndex);
+            differs.push_back(input != last.eval(input, true));
+        }
+        solver.add(mk_or(differs));
+        model next(*sym.ctx);
+        stats.queriesSent++;
+        if (checkWithPortfolio(solver, expr_vector(*sym.ctx), next) != sat)
+        {
+            break;
+        }
+        expr_vector evalVec(*sym.ctx);
+        expr variantReturnVal = returnVal;
+        evaluateModel(next, inputIndices, evalVec, variantReturnVal);
+        testCase.addVariant(evalVec, variantReturnVal);
+        stats.extraModels++;
+        last = next;
+    }
+    solver.pop();
+}
+
+// Check satisfiability of the path condition extended with a temporary constraint
+bool Solver::checkWithConstraint(solver& solver, const expr& constraint)
+{
+    int checkedCount = pathCondition.getCheckedCount();
+    pushScope(solver);                                  // save current state of the solver
+    addConstraint(solver, constraint);                  // add temporary expression
+    bool isSat = checkSat(solver) == sat;
+    popScope(solver);                                   // erase temporary expression
+    if (!isSat)
+    {
+        pathCondition.setCheckedCount(min(checkedCount, pathCondition.getSize()));
+    }
+    return isSat;
+}
+
+// Execute the while loop of the path up to its bound. Returns false if an iteration is infeasible
+bool Solver::solveLoop(const Path& path, solver& solver, int& currNodeIndex)
+{
+    auto currNode = path.at(currNodeIndex);
+    int loopStartNodeId = currNode.id;
+    int loopEndIndex = 0;
+    auto it = std::find_if(
+        path.begin() + currNodeIndex + 1,
+        path.end(),
+        [loopStartNodeId](Node node)
+        {
+            return node.id == loopStartNodeId;
+        }
+    );
+    if (it != path.end())
+    {
+        loopEndIndex = distance(path.begin(), it);
+    }
+    //cout << "Loop Start Node: " << loopStartNodeId << "\nLoop End Index: " << loopEndIndex << "\n";
+    if (loopEndIndex > 0)
+    {
+        int loopIter = 0;
+        expr loopCndExpr = applyCondition(currNode, 0);
+
+        bool loopCondSat = checkWithConstraint(solver, loopCndExpr);
+
+        Path loopBodyPath{};
+        
+        for (int k = currNodeIndex + 1; k < loopEndIndex; k++)
+        {
+            loopBodyPath.push_back(path.at(k));
+        }
+
+        currNodeIndex = loopEndIndex;
+        if (applyLoopSummary(currNode, loopBodyPath, solver))
+        {
+            return true;
+        }
+        int loopBound = getLoopBound(loopStartNodeId);
+        expr bodyReturnVal = sym.ctx->int_val(DEFAULT_NUM_VALUE);
+        while (loopIter < loopBound && loopCondSat)
+        {
+            if (!executePath(loopBodyPath, solver, bodyReturnVal))
+            {
+                return false;
+            }
+            loopCndExpr = applyCondition(currNode, 0);
+            loopCondSat = checkWithConstraint(solver, loopCndExpr);
+            loopIter++;
+        }
+        if (loopIter == loopBound && loopCondSat)
+        {
+            loopsAtBound.insert(loopStartNodeId);
+            addConstraint(solver, sym.ctx->bool_val(false));
+        }
+    }
+    else
+    {
+        expr cndExpr = applyCondition(currNode, currNode.edges.size() - 1);
+        addConstraint(solver, cndExpr);
+    }
+    return true;
+}
+
+// Extract counter initialization or increment from the 'for' loop header
+CodeLine getForLoopPart(const CodeLine& code, templateKind kind)
+{
+    CodeLine nestedVar;
+    CodeLine iteration;
+
+    int index = 2;                                      // skip 'for' and the opening parenthese
+    while (code.at(index).getLexeme() != LEX_SEMICOLON)
+    {
+        nestedVar.push_back(code.at(index));
+        index++;
+    }
+    index++;
+    while (code.at(index).getLexeme() != LEX_RIGHT_PAREN)
+    {
+        iteration.push_back(code.at(index));
+        index++;
+    }
+    return kind == TMPL_FOR_INIT ? nestedVar : iteration;
+}
+
+// Get compiled code line, translating it on first use
+const ExprTemplate& Solver::getTemplate(templateKind kind, const Node& node, int edgeIndex)
+{
+    if (options.staticSlicing && !sliceAnalyzed)
+    {
+        analyzeSlice();
+    }
+    auto key = std::make_tuple((int) kind, node.id, edgeIndex);
+    auto it = templates.find(key);
+    if (it == templates.end())
+    {
+        it = templates.emplace(key, compileLine(kind, node, edgeIndex)).first;
+    }
+    return it->second;
+}
+
+// Translate code line into Z3 expressions over variable placeholders
+ExprTemplate Solver::compileLine(templateKind kind, const Node& node, int edgeIndex)
+{
+    ExprTemplate tmpl(*sym.ctx);
+    auto savedVars = sym.vars;
+    sym.usePlaceholders();
+
+    int index = 0;
+    lexeme type = LEX_NULL;
+    switch (kind)
+    {
+    case TMPL_CONDITION:
+        tmpl.value = solveCondition(node.edges.at(edgeIndex).condition);
+        break;
+
+    case TMPL_RETURN:
+        getLexeme(node.code, index, type);
+        tmpl.value = EXPR(node.code, index, type);
+        break;
+
+    case TMPL_FOR_INIT:
+        solveAssign(getForLoopPart(node.code, kind), index, type);
+        break;
+
+    case TMPL_FOR_ITER:
+        solveStatement(getForLoopPart(node.code, kind));
+        break;
+
+    default:
+        solveStatement(node.code);
+        break;
+    }
+
+    // Every variable that no longer holds its placeholder was written by the line
+    for (int i = 0; i < sym.varIds.size(); i++)
+    {
+        int idIndex = sym.varIds.at(i);
+        if (!eq(sym.getExpr(idIndex), sym.placeholders[i]))
+        {
+            tmpl.updates.push_back(std::make_pair(idIndex, sym.getExpr(idIndex)));
+        }
+    }
+    sym.vars = savedVars;
+    return tmpl;
+}
+
+// Instantiate compiled code line against the current symbolic store
+expr Solver::applyTemplate(const ExprTemplate& tmpl)
+{
+    expr_vector currValues = sym.getCurrentValues();
+    expr value = tmpl.value;
+    value = value.substitute(sym.placeholders, currValues);
+
+    // All updates read the store as it was before the line
+    std::vector<expr> newValues;
+    for (auto& update : tmpl.updates)
+    {
+        expr newValue = update.second;
+        newValues.push_back(newValue.substitute(sym.placeholders, currValues));
+    }
+    for (int i = 0; i < tmpl.updates.size(); i++)
+    {
+        sym.setExpr(tmpl.updates.at(i).first, newValues.at(i));
+    }
+    return value;
+}
+
+// Get condition of the node's edge for the current symbolic store
+expr Solver::applyCondition(const Node& node, int edgeIndex)
+{
+    return applyTemplate(getTemplate(TMPL_CONDITION, node, edgeIndex));
+}
+
+// Execute the node's code line on the current symbolic store
+void Solver::applyStatement(templateKind kind, const Node& node)
+{
+    applyTemplate(getTemplate(kind, node));
+}
+
+expr Solver::EXPR(const std::vector<Token>& line, int& currIndex, lexeme& currType)
+{
+    expr stmntExpr = DISJ(line, currIndex, currType);
+    executeUnaryOperations();
+    return stmntExpr;
+}
+
+expr Solver::DISJ(const std::vector<Token>& line, int& currIndex, lexeme& currType)
+{
+    expr logicAddExpr = CONJ(line, currIndex, currType);
+    while (currType == LEX_OR)
+    {
+        logicAddExpr = logicAddExpr || CONJ(line, currIndex, currType);
+    }
+    return logicAddExpr;
+}
+
+expr Solver::CONJ(const std::vector<Token>& line, int& currIndex, lexeme& currType)
+{
+    expr logicMultiExpr = CMP(line, currIndex, currType);
+    while (currType == LEX_AND)
+    {
+        logicMultiExpr = logicMultiExpr && CMP(line, currIndex, currType);
+    }
+    return logicMultiExpr;
+}
+
+expr Solver::CMP(const std::vector<Token>& line, int& currIndex, lexeme& currType)
+{
+    expr stmntExpr = ADD(line, currIndex, currType);
+    lexeme op = currType;
+    switch (op)
+    {
+    case LEX_EQ: case LEX_GREATER: case LEX_LESS: case LEX_GREATER_EQ: case LEX_LESS_EQ: case LEX_NOT_EQ:
+        stmntExpr = applyComparison(op, stmntExpr, ADD(line, currIndex, currType));
+        break;
+
+    default:
+        break;
+    }
+    return stmntExpr;
+}
+
+expr Solver::ADD(const std::vector<Token>& line, int& currIndex, lexeme& currType)
+{
+    expr addExpr = MULTI(line, currIndex, currType);
+    while (currType == LEX_PLUS || currType == LEX_MINUS)
+    {
+        lexeme op = currType;
+        addExpr = applyArithmetic(op, addExpr, MULTI(line, currIndex, currType));
+    }
+    return addExpr;
+}
+
+expr Solver::MULTI(const std::vector<Token>& line, int& currIndex, lexeme& currType)
+{
+    expr multiExpr = FIN(line, currIndex, currType);
+    while (currType >= LEX_TIMES && currType <= LEX_PERCENT)
+    {
+        lexeme op = currType;
+        multiExpr = applyArithmetic(op, multiExpr, FIN(line, currIndex, currType));
+    }
+    return multiExpr;
+}
+
+expr Solver::FIN(const std::vector<Token>& line, int& currIndex, lexeme& currType)
+{
+    int lexValue;
+    expr finExpr = sym.ctx->int_val(0); // default
+    Token currToken = getLexeme(line, currIndex, currType);
+    switch (currType)
+    {
+    case LEX_NOT:
+        currToken = getLexeme(line, currIndex, currType);
+        if (currType == LEX_LEFT_PAREN)
+        {
+            finExpr = !EXPR(line, currIndex, currType);
+        }
+        else
+        {
+            lexValue = currToken.getValue();
+            finExpr = !sym.getExpr(lexValue);
+        }
+        getLexeme(line, currIndex, currType);
+        break;
+
+    case LEX_LEFT_PAREN:
+        finExpr = EXPR(line, currIndex, currType);
+        break;
+
+    case LEX_PLUS:
+        finExpr = FIN(line, currIndex, currType);
+        break;
+
+    case LEX_MINUS:
+        finExpr = -FIN(line, currIndex, currType);
+        break;
+
+    case LEX_PLUS_PLUS:
+        currToken = getLexeme(line, currIndex, currType);
+        lexValue = currToken.getValue();
+        finExpr = sym.getExpr(lexValue) + 1;
+        sym.setExpr(lexValue, finExpr);
+        checkUnaryOperation(line, currIndex, currType, lexValue);
+        break;
+
+    case LEX_MINUS_MINUS:
+        currToken = getLexeme(line, currIndex, currType);
+        lexValue = currToken.getValue();
+        finExpr = sym.getExpr(lexValue) - 1;
+        sym.setExpr(lexValue, finExpr);
+        checkUnaryOperation(line, currIndex, currType, lexValue);
+        break;
+
+    case LEX_ID:
+        lexValue = currToken.getValue();
+        finExpr = sym.getExpr(lexValue);
+        checkUnaryOperation(line, currIndex, currType, lexValue);
+        break;
+
+    case LEX_NUM:
+        if (currToken.getValue() - (int) currToken.getValue() == 0)
+        {
+            lexValue = currToken.getValue();
+            finExpr = sym.intVal(lexValue);
+        }
+        else
+        {
+            double doubleVal = currToken.getValue();
+            int numDigits = 0;
+            while (doubleVal - (int) doubleVal != 0)
+            {
+                doubleVal *= 10;
+                numDigits++;
+            }
+            lexValue = doubleVal;
+            finExpr = sym.realVal(currToken.getValue(), lexValue, std::pow(10, numDigits));
+        }
+        break;
+
+    case LEX_TRUE:
+        finExpr = sym.ctx->bool_val(true);
+        break;
+
+    case LEX_FALSE:
+        finExpr = sym.ctx->bool_val(false);
+        break;
+
+    case LEX_QUOTE_SINGLE:
+        currToken = getLexeme(line, currIndex, currType);
+        finExpr = sym.charVal(charConsts.at(currToken.getValue()));
+        getLexeme(line, currIndex, currType);
+        break;
+
+    case LEX_QUOTE_DOUBLE:
+		currToken = getLexeme(line, currIndex, currType);
+		finExpr = sym.strVal(strConsts.at(currToken.getValue()));
+        getLexeme(line, currIndex, currType);
+        break;
+
+    default:
+        break;
+    }
+    if (currIndex < line.size())
+    {
+        getLexeme(line, currIndex, currType);
+    }
+    return finExpr;
+}
+
+// Get all possible paths in a loop
+void Solver::getAllLoopPaths(vector<Path>& loopPaths, CFG& cfg, int currNodeId, int loopStartNodeId, Path currPath)
+{
+    Node currNode = cfg.nodes[currNodeId];
+    currPath.push_back(currNode);
+
+    for (int edgeIndex = 0; edgeIndex < currNode.edges.size(); edgeIndex++)
+    {
+        const Edge& edge = currNode.edges.at(edgeIndex);
+        if (isDeadEdge(currNodeId, edgeIndex))
+        {
+            continue;
+        }
+        if (edge.idTarget != loopStartNodeId)
+        {
+            getAllLoopPaths(loopPaths, cfg, edge.idTarget, loopStartNodeId, currPath);
+        }
+        else
+        {
+            loopPaths.push_back(currPath);
+        }
+    }
+}
+
+// Get all possible paths in a loop, collecting them on the first visit
+const std::vector<Path>& Solver::getLoopPaths(int loopStartNodeId)
+{
+    auto it = loopPaths.find(loopStartNodeId);
+    if (it == loopPaths.end())
+    {
+        vector<Path> paths{};
+        getAllLoopPaths(paths, cfg, loopStartNodeId + 1, loopStartNodeId);
+        it = loopPaths.emplace(loopStartNodeId, paths).first;
+    }
+    return it->second;
+}
+
+// Check whether the expression simplifies to zero
+bool isZero(const expr& e)
+{
+    int64_t value;
+    return e.simplify().is_numeral_i64(value) && value == 0;
+}
+
+// Replace placeholders in the expression with the values of a symbolic state
+expr Solver::substituteState(expr e, const std::vector<expr>& state)
+{
+    expr_vector values(*sym.ctx);
+    for (auto& value : state)
+    {
+        values.push_back(value);
+    }
+    return e.substitute(sym.placeholders, values);
+}
+
+// Apply compiled code line to a symbolic state given in the order of placeholders
+void Solver::applyTemplateTo(const ExprTemplate& tmpl, std::vector<expr>& state)
+{
+    std::vector<expr> newValues;
+    for (auto& update : tmpl.updates)
+    {
+        newValues.push_back(substituteState(update.second, state));
+    }
+    for (int i = 0; i < tmpl.updates.size(); i++)
+    {
+        state.at(sym.varPositions.at(tmpl.updates.at(i).first)) = newValues.at(i);
+    }
+}
+
+// Get closed form of the loop, computing it on the first visit
+const LoopSummary& Solver::getLoopSummary(const Node& loopNode, const Path& body)
+{
+    std::vector<int> key{ loopNode.id };
+    for (auto& node : body)
+    {
+        key.push_back(node.id);
+    }
+    auto it = loopSummaries.find(key);
+    if (it == loopSummaries.end())
+    {
+        it = loopSummaries.emplace(key, summarizeLoop(loopNode, body)).first;
+    }
+    return it->second;
+}
+
+// Compute closed form of a loop with a straight-line body.
+// The guard must compare two expressions whose difference h changes by a constant step,
+// and every variable must change by an arithmetic progression or be assigned a loop-invariant value
+LoopSummary Solver::summarizeLoop(const Node& loopNode, const Path& body)
+{
+    LoopSummary summary(*sym.ctx);
+    for (auto& node : body)
+    {
+        lexeme type = node.code.front().getLexeme();
+        if (type == LEX_IF || type == LEX_WHILE || type == LEX_FOR || type == LEX_DO || type == LEX_RETURN ||
+            type == LEX_SWITCH || type == LEX_BREAK || type == LEX_CONTINUE)
+        {
+            return summary;
+        }
+    }
+    const ExprTemplate& guardTmpl = getTemplate(TMPL_CONDITION, loopNode, 0);
+    if (!guardTmpl.updates.empty())
+    {
+        return summary;
+    }
+
+    // Values of the variables after one iteration over their values before it
+    std::vector<expr> step;
+    for (int i = 0; i < sym.placeholders.size(); i++)
+    {
+        step.push_back(sym.placeholders[i]);
+    }
+    for (auto& node : body)
+    {
+        applyTemplateTo(getTemplate(TMPL_STATEMENT, node), step);
+    }
+    if (loopNode.code.front().getLexeme() == LEX_FOR)
+    {
+        applyTemplateTo(getTemplate(TMPL_FOR_ITER, loopNode), step);
+    }
+    std::unordered_set<unsigned> modified;
+    for (int i = 0; i < step.size(); i++)
+    {
+        if (!eq(step.at(i), sym.placeholders[i]))
+        {
+            modified.insert(sym.placeholders[i].id());
+        }
+    }
+
+    // Trip count from the guard
+    expr guard = guardTmpl.value;
+    if (!guard.is_app() || guard.num_args() != 2 || !guard.arg(0).is_int() || !guard.arg(1).is_int())
+    {
+        return summary;
+    }
+    expr h = guard.arg(0) - guard.arg(1);
+    expr h1 = substituteState(h, step);
+    expr h2 = substituteState(h1, step);
+    int64_t slope;
+    if (!(h1 - h).simplify().is_numeral_i64(slope) || slope == 0 || !isZero(h2 - 2 * h1 + h))
+    {
+        return summary;
+    }
+    expr zero = sym.ctx->int_val(0);
+    expr tripCount = zero;
+    switch (guard.decl().decl_kind())
+    {
+    case Z3_OP_LT:
+        if (slope < 0) return summary;
+        tripCount = ite(h < 0, (-h + sym.ctx->int_val(slope - 1)) / sym.ctx->int_val(slope), zero);
+        break;
+
+    case Z3_OP_LE:
+        if (slope < 0) return summary;
+        tripCount = ite(h <= 0, -h / sym.ctx->int_val(slope) + 1, zero);
+        break;
+
+    case Z3_OP_GT:
+        if (slope > 0) return summary;
+        tripCount = ite(h > 0, (h + sym.ctx->int_val(-slope - 1)) / sym.ctx->int_val(-slope), zero);
+        break;
+
+    case Z3_OP_GE:
+        if (slope > 0) return summary;
+        tripCount = ite(h >= 0, h / sym.ctx->int_val(-slope) + 1, zero);
+        break;
+
+    default:
+        return summary;
+    }
+
+    // Values of the modified variables after the loop
+    for (int i = 0; i < step.size(); i++)
+    {
+        expr initVal = sym.placeholders[i];
+        if (!modified.count(initVal.id()))
+        {
+            continue;
+        }
+        std::unordered_set<unsigned> visited;
+        expr exitVal = step.at(i);
+        if (dependsOn(exitVal, modified, visited))
+        {
+            if (!initVal.is_arith())
+            {
+                return summary;
+            }
+            expr delta = (step.at(i) - initVal).simplify();
+            expr delta1 = substituteState(delta, step);
+            expr delta2 = substituteState(delta1, step);
+            if (!isZero(delta2 - 2 * delta1 + delta))
+            {
+                return summary;
+            }
+            // Sum of the arithmetic progression of increments
+            expr k = initVal.is_real() ? to_real(tripCount) : tripCount;
+            exitVal = initVal + k * delta + (delta1 - delta) * (k * (k - 1) / 2);
+        }
+        summary.closedForm.updates.push_back(std::make_pair(sym.varIds.at(i), exitVal.simplify()));
+    }
+    summary.closedForm.value = tripCount.simplify();
+    summary.summarized = true;
+    return summary;
+}
+
+// Execute the whole loop in one step if it has a closed form
+bool Solver::applyLoopSummary(const Node& loopNode, const Path& body, solver& solver)
+{
+    if (!options.summarizeLoops)
+    {
+        return false;
+    }
+    const LoopSummary& summary = getLoopSummary(loopNode, body);
+    if (!summary.summarized)
+    {
+        stats.loopsUnrolled++;
+        return false;
+    }
+    expr tripCount = applyTemplate(summary.closedForm).simplify();
+    for (auto& update : summary.closedForm.updates)
+    {
+        sym.setExpr(update.first, sym.getExpr(update.first).simplify());
+    }
+    addConstraint(solver, tripCount >= 1);              // the path enters the loop body
+    stats.loopsSummarized++;
+    return true;
+}
+
+// Get current iteration bound of an unrolled loop
+int Solver::getLoopBound(int loopStartNodeId)
+{
+    auto it = loopBounds.find(loopStartNodeId);
+    if (it == loopBounds.end())
+    {
+        it = loopBounds.emplace(loopStartNodeId, min(options.initialLoopBound, maxIterForLoops)).first;
+    }
+    return it->second;
+}
+
+// Raise bounds of the loops up to maxIterForLoops. Returns false if none of them could grow
+bool Solver::deepenLoopBounds(const std::set<int>& loops)
+{
+    bool deepened = false;
+    for (auto& loopStartNodeId : loops)
+    {
+        int& bound = loopBounds[loopStartNodeId];
+        if (bound < maxIterForLoops)
+        {
+            bound = bound > maxIterForLoops / options.loopBoundGrowth ? maxIterForLoops : bound * options.loopBoundGrowth;
+            deepened = true;
+        }
+    }
+    return deepened;
+}
+
+bool Solver::checkLoopBody(Path body, z3::solver& solver)
+{
+    expr bodyReturnVal = sym.ctx->int_val(DEFAULT_NUM_VALUE);
+    PersistentStore savedVars = sym.vars;               // the trial run must not change the store
+    int checkedCount = pathCondition.getCheckedCount();
+    pushScope(solver);
+    auto isSat = executePath(body, solver, bodyReturnVal) && checkSat(solver) == sat;
+    popScope(solver);
+    if (!isSat)
+    {
+        pathCondition.setCheckedCount(min(checkedCount, pathCondition.getSize()));
+    }
+    sym.vars = savedVars;
+    return isSat;
+}
+
+void Solver::checkUnaryOperation(const std::vector<Token>& line, int& currIndex, lexeme& currType, int idValue)
+{
+    if (currIndex < line.size())
+    {
+        getLexeme(line, currIndex, currType);
+        if (currType == LEX_PLUS_PLUS || currType == LEX_MINUS_MINUS)
+        {
+            unaryOpTable.push_back(std::make_pair(idValue, currType));
+        }
+        else
+        {
+            ungetLexeme(line, currIndex, currType);
+        }
+    }
+}
+
+void Solver::executeUnaryOperations()
+{
+    for (auto& entry : unaryOpTable)
+    {
+        int idVal = entry.first;
+        lexeme unaryOpType = entry.second;
+        expr unaryOpResult = unaryOpType == LEX_PLUS_PLUS ?
+            sym.getExpr(idVal) + 1 :
+            sym.getExpr(idVal) - 1;
+        sym.setExpr(idVal, unaryOpResult);
+    }
+    unaryOpTable.clear();
+}
+
+Solver::Solver(
+    CFG currCfg, 
+    std::vector<Identifier> ids,
+    std::vector<char> charConsts,
+    std::vector<string> strConsts,
+    int maxIter,
+    SolverOptions options,
+    std::unique_ptr<context> warmContext
+) : cfg(currCfg), sym(std::move(warmContext)), maxIterForLoops(maxIter), ids(ids), strConsts(strConsts), charConsts(charConsts), options(options),
+    pathCondition(ids.size()), sliceSolver(*sym.ctx), diskCache(options.cacheDirectory), preSolver(*sym.ctx),
+    portfolio(*sym.ctx, options.machineArithmetic), capture(options.captureDirectory)
+{
+    pendingConstraints = 0;
+    flowAnalyzed = false;
+    intervalsAnalyzed = false;
+    sliceAnalyzed = false;
+    currPathId = -1;
+    currNodeId = -1;
+    pathsInContext = 0;
+    budgetExhausted = false;
+    queryUnknown = false;
+    sym.machineArithmetic = options.machineArithmetic;
+    sym.stringTheory = options.stringTheory;
+    sym.importVars(ids);
+    sliceSolver = createSolver();
+
+    std::vector<Identifier> inputVars;
+    std::vector<int> inputIndices;
+    std::vector<z3::sort> inputSorts;
+    getInputs(inputVars, inputIndices);
+    for (auto& idIndex : inputIndices)
+    {
+        inputSorts.push_back(sym.initVars.get(idIndex).get_sort());
+    }
+    testStore = std::shared_ptr<TestSuiteStore>(new TestSuiteStore(inputVars, inputSorts));
+}
+
+void Solver::setMaxIterForLoops(int newMaxIter)
+{
+    maxIterForLoops = newMaxIter;
+}
+
+SolverStats Solver::getStats() const
+{
+    return stats;
+}
+
+std::map<int, int> Solver::getLoopBounds() const
+{
+    return loopBounds;
+}
+
+// Symbolically execute the path and add its constraints to the solver
+bool Solver::executePath(const Path& path, solver& solver, expr& returnVal, int startIndex, bool saveCheckpoints)
+{
+    int horizon = saveCheckpoints && !checkpoints.empty() ? checkpoints.back().horizon : -1;
+    for (int i = startIndex; i < path.size(); i++)
+    {
+        const Node& node = path[i];
+        currNodeId = node.id;
+        if (saveCheckpoints && (checkpoints.empty() || checkpoints.back().nodeIndex < i))
+        {
+            pushScope(solver);
+            checkpoints.push_back(Checkpoint(i, horizon, sym.vars, returnVal, loopsAtBound));
+        }
+        horizon = max(horizon, i);
+        Node nextNode;
+
+        int index = 0;
+        lexeme type;
+        int loopStartNodeId;
+        int loopStartIndex;
+        int loopEndIndex;
+        Path::const_iterator pathIt;
+
+        getLexeme(node.code, index, type);
+        switch (type)
+        {
+        case LEX_IF:
+            if (i == path.size() - 1)
+            {
+                expr cndExpr = applyCondition(node, node.edges.size() - 1);
+                if (node.edges.size() == 1)
+                {
+                    cndExpr = !cndExpr;
+                }
+                bool stable = saveCheckpoints && isStableDecision(node, node.edges.size() - 1);
+                addConstraint(solver, cndExpr, stable ? std::make_pair(node.id, -1) : std::make_pair(-1, -1));
+            }
+            else
+            {
+                horizon = max(horizon, i + 1);
+                nextNode = path.at(i + 1);
+                for (int edgeIndex = 0; edgeIndex < node.edges.size(); edgeIndex++)
+                {
+                    if (node.edges.at(edgeIndex).idTarget == nextNode.id)
+                    {
+                        expr cndExpr = applyCondition(node, edgeIndex);
+                        bool stable = saveCheckpoints && isStableDecision(node, edgeIndex);
+                        addConstraint(solver, cndExpr, stable ? std::make_pair(node.id, nextNode.id) : std::make_pair(-1, -1));
+                    }
+                }
+            }
+            break;
+
+        case LEX_DO:
+            break;
+
+        case LEX_WHILE:
+            loopStartIndex = i;
+            if (!solveLoop(path, solver, i))
+            {
+                return false;
+            }
+            horizon = max(horizon, i > loopStartIndex ? i : (int) path.size());
+            break;
+
+        case LEX_FOR:
+            applyStatement(TMPL_FOR_INIT, node);
+
+            loopStartNodeId = node.id;
+            loopEndIndex = 0;
+            pathIt = std::find_if(
+                path.begin() + i + 1,
+                path.end(),
+                [loopStartNodeId](Node node)
+                {
+                    return node.id == loopStartNodeId;
+                }
+            );
+            if (pathIt != path.end())
+            {
+                loopEndIndex = distance(path.begin(), pathIt);
+            }
+            horizon = max(horizon, loopEndIndex > 0 ? loopEndIndex : (int) path.size());
+            if (loopEndIndex > 0)
+            {
+                int loopIter = 0;
+                expr cndExpr = applyCondition(node, 0);
+
+                bool loopCondSat = checkWithConstraint(solver, cndExpr);
+
+                Path loopBodyPath{};
+                for (int k = i + 1; k < loopEndIndex; k++)
+                {
+                    loopBodyPath.push_back(path[k]);
+                }
+                i = loopEndIndex;
+                if (applyLoopSummary(node, loopBodyPath, solver))
+                {
+                    break;
+                }
+
+				bool requiredPathIsFeasible = false;
+                expr bodyReturnVal = sym.ctx->int_val(DEFAULT_NUM_VALUE);
+
+				// Get all possible paths in the loop body
+                const vector<Path>& loopPaths = getLoopPaths(loopStartNodeId);
+                int loopBound = getLoopBound(loopStartNodeId);
+                while (loopIter < loopBound && loopCondSat)
+                {
+					bool pathIsFeasible = checkLoopBody(loopBodyPath, solver);
+                    if (pathIsFeasible)
+                    {
+						requiredPathIsFeasible = true;
+                        if (!executePath(loopBodyPath, solver, bodyReturnVal))
+                        {
+                            return false;
+                        }
+                    }
+                    else
+                    {
+                        int k = 0;
+                        while (k < loopPaths.size() && !pathIsFeasible)
+                        {
+							pathIsFeasible = checkLoopBody(loopPaths.at(k), solver);
+                            k++;
+                        }
+                        if (!executePath(loopPaths.at(k - 1), solver, bodyReturnVal))
+                        {
+                            return false;
+                        }
+					}
+
+                    // Increment
+                    applyStatement(TMPL_FOR_ITER, node);
+
+                    cndExpr = applyCondition(node, 0);
+                    loopCondSat = checkWithConstraint(solver, cndExpr);
+                    loopIter++;
+                }
+
+                if (loopIter == loopBound && loopCondSat)
+                {
+                    loopsAtBound.insert(loopStartNodeId);
+                }
+                if (loopsAtBound.count(loopStartNodeId) || !requiredPathIsFeasible)
+                {
+                    addConstraint(solver, sym.ctx->bool_val(false));
+                }
+            }
+            else
+            {
+                expr cndExpr = applyCondition(node, node.edges.size() - 1);
+                addConstraint(solver, cndExpr);
+            }
+            break;
+
+        case LEX_RETURN:
+            returnVal = applyTemplate(getTemplate(TMPL_RETURN, node));
+            break;
+
+        default:
+            applyStatement(TMPL_STATEMENT, node);
+            break;
+        }
+
+        // Assignments cannot change satisfiability, so the solver is queried according to the policy
+        if (checkIsDue())
+        {
+            if (checkSat(solver) == unsat)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            stats.checksSaved++;
+        }
+    }
+    return true;
+}
+
+// Restore the state saved at the deepest checkpoint shared with the previous path.
+// Returns index of the node to continue the execution from
+int Solver::resumeFromCheckpoint(const Path& path, solver& solver, expr& returnVal)
+{
+    int commonLength = 0;
+    while (
+        commonLength < path.size() &&
+        commonLength < prevPath.size() &&
+        path.at(commonLength).id == prevPath.at(commonLength).id
+    ) {
+        commonLength++;
+    }
+
+    int k = checkpoints.size() - 1;
+    while (k >= 0 && (checkpoints.at(k).horizon >= commonLength || checkpoints.at(k).nodeIndex > commonLength))
+    {
+        k--;
+    }
+    if (k < (int) checkpoints.size() - 1)
+    {
+        popScope(solver, checkpoints.size() - k - 1);
+    }
+    checkpoints.erase(checkpoints.begin() + (k + 1), checkpoints.end());
+    prevPath = path;
+    pendingConstraints = 0;
+    pathCondition.setCheckedCount(pathCondition.getSize());
+
+    if (k < 0)
+    {
+        sym.resetVars();
+        loopsAtBound.clear();
+        return 0;
+    }
+    popScope(solver);                                   // drop constraints added after the checkpoint
+    pushScope(solver);
+    sym.vars = checkpoints.back().vars;
+    returnVal = checkpoints.back().returnVal;
+    loopsAtBound = checkpoints.back().loopsAtBound;
+    return checkpoints.back().nodeIndex;
+}
+
+TestCase Solver::evaluatePathConstraints(const Path& path, solver& solver, bool debugPrint)
+{
+    if (options.pruneByCores && containsKnownCore(path))
+    {
+        stats.pathsPruned++;
+        loopsAtBound.clear();
+        return TestCase();
+    }
+    expr returnVal = sym.ctx->int_val(DEFAULT_NUM_VALUE);
+    int startIndex = resumeFromCheckpoint(path, solver, returnVal);
+    queryUnknown = false;
+    if (!executePath(path, solver, returnVal, startIndex, true))
+    {
+        if (queryUnknown)
+        {
+            markUndecided(path);
+        }
+        return TestCase();
+    }
+    vector<Identifier> inputVars;
+    vector<int> inputIndices;
+    getInputs(inputVars, inputIndices);
+
+    expr_vector evalVec(*sym.ctx);
+    model m(*sym.ctx);
+    expr symbolicReturnVal = returnVal;
+    bool isSat = solveClusters(solver, m);
+    if (isSat)
+    {
+        evaluateModel(m, inputIndices, evalVec, returnVal);
+    }
+    else if (queryUnknown)
+    {
+        markUndecided(path);
+    }
+
+    // Print feasibility results
+    if (debugPrint)
+    {
+        std::cout << "Path: ";
+        for (auto& line : path)
+        {
+            std::cout << line.id << " ";
+        }
+        std::cout << "\n  Result: " << (isSat ? "feasible" : queryUnknown ? "unknown" : "infeasible") << "\n";
+
+        if (isSat)
+        {
+            std::cout << "  Test case:\n";
+            for (int i = 0; i < evalVec.size(); i++)
+            {
+                string evalStr = evalVec[i].to_string();
+                std::cout << "    " << inputVars.at(i).getName() << " = " << evalStr << "\n";
+            }
+            std::cout << "  Return value: " << returnVal.simplify() << "\n";
+        }
+        cout << "\n";
+    }
+
+    if (isSat)
+    {
+        TestCase testCase(
+            testStore,
+            evalVec,
+            returnVal
+        );
+        findVariants(testCase, solver, m, inputIndices, symbolicReturnVal);
+        return testCase;
+    }
+    return TestCase();
+}
+
+void Solver::debugPrintPaths()
+{
+    cout << "PATHS COLLECTED\n";
+    int i = 1;
+    for (auto& path : paths)
+    {
+        cout << "Path " << i << ":\n   ";
+        for (auto& node : path)
+        {
+            cout << node.id << " ";
+        }
+        cout << "\n";
+        i++;
+    }
+    cout << "\n";
+}
+
+// Create a solver with the tactic pipeline, parameters and query timeout of the options
+solver Solver::createSolver()
+{
+    return options.createSolver(*sym.ctx);
+}
+
+// Limit the time of every check of the solver, 0 for no limit
+void Solver::setTimeout(solver& solver, unsigned timeout)
+{
+    params p(*sym.ctx);
+    p.set("timeout", timeout > 0 ? timeout : UINT_MAX);
+    solver.set(p);
+}
+
+// Check whether time, queries and Z3 memory are left. Once exhausted, the budget stays exhausted
+bool Solver::withinBudget()
+{
+    if (!budgetExhausted)
+    {
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        budgetExhausted =
+            (options.timeBudget > 0 && elapsed >= options.timeBudget) ||
+            (options.queryBudget > 0 && stats.queriesSent >= options.queryBudget) ||
+            (options.memoryBudget > 0 && Z3_get_estimated_alloc_size() >= ((uint64_t) options.memoryBudget << 20));
+    }
+    return !budgetExhausted;
+}
+
+// Copy of the template with its expressions translated into the context
+static ExprTemplate translateTemplate(const ExprTemplate& tmpl, context& ctx)
+{
+    ExprTemplate translated(ctx);
+    translated.value = expr(ctx, Z3_translate(tmpl.value.ctx(), tmpl.value, ctx));
+    for (auto& update : tmpl.updates)
+    {
+        translated.updates.push_back(std::make_pair(update.first, expr(ctx, Z3_translate(update.second.ctx(), update.second, ctx))));
+    }
+    return translated;
+}
+
+// Check whether the context has served enough paths or Z3 has allocated enough memory to recycle it
+bool Solver::isRecycleDue() const
+{
+    return
+        (options.recyclePaths > 0 && pathsInContext >= options.recyclePaths) ||
+        (options.recycleMemory > 0 && Z3_get_estimated_alloc_size() >= ((uint64_t) options.recycleMemory << 20));
+}
+
+// Replace the Z3 context by a fresh one between two paths. Z3 never frees the terms a context
+// has created, so a long search grows its memory path by path. Only the declarations of the
+// variables and the compiled templates and loop summaries move into the new context; the solvers
+// are rebuilt, and the checkpoints, the path condition and the counterexample cache are dropped.
+// The next path starts from the entry, and the old context is released last
+void Solver::recycleContext(solver& solver)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<context> old = sym.renewContext(ids);
+    context& ctx = *sym.ctx;
+
+    std::map<std::tuple<int, int, int>, ExprTemplate> oldTemplates;
+    oldTemplates.swap(templates);
+    for (auto& entry : oldTemplates)
+    {
+        templates.emplace(entry.first, translateTemplate(entry.second, ctx));
+    }
+    std::map<std::vector<int>, LoopSummary> oldSummaries;
+    oldSummaries.swap(loopSummaries);
+    for (auto& entry : oldSummaries)
+    {
+        LoopSummary summary(ctx);
+        summary.summarized = entry.second.summarized;
+        summary.closedForm = translateTemplate(entry.second.closedForm, ctx);
+        loopSummaries.emplace(entry.first, summary);
+    }
+
+    checkpoints.clear();
+    scopeSizes.clear();
+    prevPath = {};
+    pendingConstraints = 0;
+    pathCondition = PathCondition(ids.size());
+    queryCache = CounterexampleCache();
+    solver = createSolver();
+    sliceSolver = createSolver();
+    preSolver.setContext(ctx);
+    portfolio.setContext(ctx);
+
+    // Flow analysis keeps the AST IDs of the placeholders, which change with the context
+    writtenVars.clear();
+    cyclicNodes.clear();
+    flowAnalyzed = false;
+
+    pathsInContext = 0;
+    stats.contextsRecycled++;
+    stats.recycleTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Clear the coverage bitmaps, giving every node and edge of the CFG its bit
+void Solver::initCoverage()
+{
+    int maxId = 0;
+    edgeBits.clear();
+    for (auto& entry : cfg.nodes)
+    {
+        maxId = max(maxId, entry.first);
+        for (auto& edge : entry.second.edges)
+        {
+            edgeBits.emplace(std::make_pair(entry.first, edge.idTarget), edgeBits.size());
+        }
+    }
+    nodeCoverage.assign(maxId + 1, false);
+    edgeCoverage.assign(edgeBits.size(), false);
+}
+
+// Check whether a test case covers the node (id, -1) or the edge (from, to)
+bool Solver::isCovered(std::pair<int, int> target) const
+{
+    if (target.second < 0)
+    {
+        return nodeCoverage.at(target.first);
+    }
+    auto it = edgeBits.find(target);
+    return it == edgeBits.end() || edgeCoverage.at(it->second);
+}
+
+// Set the bits of the nodes and edges of a feasible path
+void Solver::markCovered(const Path& path)
+{
+    for (int i = 0; i < path.size(); i++)
+    {
+        nodeCoverage.at(path.at(i).id) = true;
+        if (i + 1 < path.size())
+        {
+            auto it = edgeBits.find(std::make_pair(path.at(i).id, path.at(i + 1).id));
+            if (it != edgeBits.end())
+            {
+                edgeCoverage.at(it->second) = true;
+            }
+        }
+    }
+}
+
+// Remember the nodes of a path whose feasibility is unknown
+void Solver::markUndecided(const Path& path)
+{
+    for (auto& node : path)
+    {
+        undecidedNodes.insert(node.id);
+    }
+}
+
+// Count the distinct uncovered targets of the goal on the path: nodes for statement coverage, edges otherwise.
+// distance receives the number of nodes executed before the first of them
+int Solver::countUncovered(const Path& path, int& distance) const
+{
+    std::set<std::pair<int, int>> uncovered;
+    distance = path.size();
+    for (int i = 0; i < path.size(); i++)
+    {
+        std::pair<int, int> target = std::make_pair(path.at(i).id, -1);
+        if (options.goal != GOAL_STATEMENTS)
+        {
+            if (i + 1 == path.size())
+            {
+                break;
+            }
+            target.second = path.at(i + 1).id;
+        }
+        if (!isCovered(target))
+        {
+            uncovered.insert(target);
+            distance = min(distance, i);
+        }
+    }
+    return uncovered.size();
+}
+
+// Choose the path to evaluate next: the next one in order when all paths are wanted, otherwise the path
+// with the most uncovered targets, reaching the first of them soonest. Returns -1 if no path can add coverage
+int Solver::selectNextPath(const std::vector<bool>& evaluated) const
+{
+    int best = -1;
+    int bestCount = 0;
+    int bestDistance = 0;
+    for (int i = 0; i < paths.size(); i++)
+    {
+        if (evaluated.at(i))
+        {
+            continue;
+        }
+        if (options.goal == GOAL_ALL_PATHS)
+        {
+            return i;
+        }
+        int distance;
+        int count = countUncovered(paths.at(i), distance);
+        if (count > bestCount || (count == bestCount && count > 0 && distance < bestDistance))
+        {
+            best = i;
+            bestCount = count;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+// Count distinct subexpressions of the expression, stopping above the limit
+int countExprNodes(const expr& e, int limit)
+{
+    std::unordered_set<unsigned> visited;
+    std::vector<expr> stack{ e };
+    while (!stack.empty() && visited.size() <= limit)
+    {
+        expr curr = stack.back();
+        stack.pop_back();
+        if (visited.insert(curr.id()).second && curr.is_app())
+        {
+            for (int i = 0; i < curr.num_args(); i++)
+            {
+                stack.push_back(curr.arg(i));
+            }
+        }
+    }
+    return visited.size();
+}
+
+// Get updates of the template by the positions of the variables instead of their identifier IDs
+std::vector<std::pair<int, expr>> Solver::getUpdatePositions(const ExprTemplate& tmpl)
+{
+    std::vector<std::pair<int, expr>> updates;
+    for (auto& update : tmpl.updates)
+    {
+        updates.push_back(std::make_pair(sym.varPositions.at(update.first), update.second));
+    }
+    return updates;
+}
 
-expr Solver::MULTI(const std::vector<Token>& line, int& currIndex, lexeme& currType)
+// Prove edges and nodes dead by interval analysis of the CFG, before any path is solved
+void Solver::analyzeIntervals()
 {
-    expr multiExpr = FIN(line, currIndex, currType);
-    while (currType >= LEX_TIMES && currType <= LEX_PERCENT)
+    intervalsAnalyzed = true;
+    auto start = std::chrono::steady_clock::now();
+    IntervalAnalysis analysis(sym.placeholders);
+    for (auto& entry : cfg.nodes)
     {
-        switch (currType)
+        const Node& node = entry.second;
+        std::vector<std::pair<int, expr>> entryUpdates;
+        std::vector<std::pair<int, expr>> backUpdates;
+        switch (node.code.front().getLexeme())
         {
-        case LEX_TIMES:
-            multiExpr = multiExpr * FIN(line, currIndex, currType);
+        case LEX_IF: case LEX_WHILE: case LEX_DO: case LEX_RETURN:
             break;
 
-        case LEX_SLASH:
-            multiExpr = multiExpr / FIN(line, currIndex, currType);
-            break;
-
-        case LEX_PERCENT:
-            multiExpr = multiExpr % FIN(line, currIndex, currType);
+        case LEX_FOR:
+            entryUpdates = getUpdatePositions(getTemplate(TMPL_FOR_INIT, node));
+            backUpdates = getUpdatePositions(getTemplate(TMPL_FOR_ITER, node));
             break;
 
         default:
+            entryUpdates = getUpdatePositions(getTemplate(TMPL_STATEMENT, node));
+            backUpdates = entryUpdates;
             break;
         }
+        analysis.addNode(node.id, entryUpdates, backUpdates);
+        for (int edgeIndex = 0; edgeIndex < node.edges.size(); edgeIndex++)
+        {
+            const Edge& edge = node.edges.at(edgeIndex);
+            if (edge.condition.empty())
+            {
+                analysis.addEdge(node.id, edge.idTarget, sym.ctx->bool_val(true), {});
+            }
+            else
+            {
+                const ExprTemplate& tmpl = getTemplate(TMPL_CONDITION, node, edgeIndex);
+                analysis.addEdge(node.id, edge.idTarget, tmpl.value, getUpdatePositions(tmpl));
+            }
+        }
     }
-    return multiExpr;
-}
+    analysis.run(cfg.idEntry);
 
-expr Solver::FIN(const std::vector<Token>& line, int& currIndex, lexeme& currType)
-{
-    int lexValue;
-    expr finExpr = sym.ctx.int_val(0); // default
-    Token currToken = getLexeme(line, currIndex, currType);
-    switch (currType)
+    for (auto& entry : cfg.nodes)
     {
-    case LEX_NOT:
-        currToken = getLexeme(line, currIndex, currType);
-        if (currType == LEX_LEFT_PAREN)
+        if (!analysis.isReachable(entry.first))
         {
-            finExpr = !EXPR(line, currIndex, currType);
+            deadNodes.insert(entry.first);
         }
-        else
+        for (int edgeIndex = 0; edgeIndex < entry.second.edges.size(); edgeIndex++)
         {
-            lexValue = currToken.getValue();
-            finExpr = !sym.getExpr(lexValue);
+            if (!analysis.isFeasible(entry.first, edgeIndex))
+            {
+                deadEdges.insert(std::make_pair(entry.first, edgeIndex));
+            }
         }
-        getLexeme(line, currIndex, currType);
-        break;
+    }
+    stats.deadEdges = deadEdges.size();
+    stats.deadNodes = deadNodes.size();
+    stats.analysisTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
 
-    case LEX_LEFT_PAREN:
-        finExpr = EXPR(line, currIndex, currType);
-        break;
+// Check whether interval analysis proved that no execution takes the edge
+bool Solver::isDeadEdge(int nodeId, int edgeIndex) const
+{
+    return deadEdges.count(std::make_pair(nodeId, edgeIndex)) > 0;
+}
 
-    case LEX_PLUS:
-        finExpr = FIN(line, currIndex, currType);
-        break;
+// Get the nodes interval analysis proves unreachable
+std::set<int> Solver::getDeadNodes()
+{
+    if (options.intervalAnalysis && !intervalsAnalyzed)
+    {
+        analyzeIntervals();
+    }
+    return deadNodes;
+}
 
-    case LEX_MINUS:
-        finExpr = -FIN(line, currIndex, currType);
-        break;
+// Get the edges interval analysis proves dead, as their source and target node IDs
+std::vector<std::pair<int, int>> Solver::getDeadEdges()
+{
+    if (options.intervalAnalysis && !intervalsAnalyzed)
+    {
+        analyzeIntervals();
+    }
+    std::vector<std::pair<int, int>> edges;
+    for (auto& edge : deadEdges)
+    {
+        edges.push_back(std::make_pair(edge.first, cfg.nodes.at(edge.first).edges.at(edge.second).idTarget));
+    }
+    return edges;
+}
 
-    case LEX_PLUS_PLUS:
-        currToken = getLexeme(line, currIndex, currType);
-        lexValue = currToken.getValue();
-        finExpr = sym.getExpr(lexValue) + sym.ctx.int_val(1);
-        sym.setExpr(lexValue, finExpr);
-        checkUnaryOperation(line, currIndex, currType, lexValue);
-        break;
+// Collect the positions of the variables the expression reads
+void collectReads(const expr& e, const std::map<unsigned, int>& positions, std::set<int>& reads, std::unordered_set<unsigned>& visited)
+{
+    if (!visited.insert(e.id()).second)
+    {
+        return;
+    }
+    auto it = positions.find(e.id());
+    if (it != positions.end())
+    {
+        reads.insert(it->second);
+        return;
+    }
+    if (e.is_app())
+    {
+        for (int i = 0; i < e.num_args(); i++)
+        {
+            collectReads(e.arg(i), positions, reads, visited);
+        }
+    }
+}
 
-    case LEX_MINUS_MINUS:
-        currToken = getLexeme(line, currIndex, currType);
-        lexValue = currToken.getValue();
-        finExpr = sym.getExpr(lexValue) - sym.ctx.int_val(1);
-        sym.setExpr(lexValue, finExpr);
-        checkUnaryOperation(line, currIndex, currType, lexValue);
-        break;
+// Get the variables needed before a code line, given the ones needed after it.
+// Unless all updates are kept, only the updates of needed variables read anything
+std::set<int> Solver::transferReads(const ExprTemplate& tmpl, const std::set<int>& after, bool keepAll, const std::map<unsigned, int>& positions)
+{
+    std::set<int> before = after;
+    std::unordered_set<unsigned> visited;
+    for (auto& update : tmpl.updates)
+    {
+        before.erase(sym.varPositions.at(update.first));
+    }
+    for (auto& update : tmpl.updates)
+    {
+        if (keepAll || after.count(sym.varPositions.at(update.first)))
+        {
+            collectReads(update.second, positions, before, visited);
+        }
+    }
+    return before;
+}
 
-    case LEX_ID:
-        lexValue = currToken.getValue();
-        finExpr = sym.getExpr(lexValue);
-        checkUnaryOperation(line, currIndex, currType, lexValue);
-        break;
+// Get the variables needed on entering the node, given the ones needed after its code.
+// A for loop runs its initialization or its iteration step, so both are kept whole
+std::set<int> Solver::getLiveBefore(int nodeId, std::map<int, std::set<int>>& live, const std::map<unsigned, int>& positions)
+{
+    if (!cfg.nodes.count(nodeId))
+    {
+        return std::set<int>();
+    }
+    const Node& node = cfg.nodes.at(nodeId);
+    std::set<int> before;
+    std::set<int> iterBefore;
+    switch (node.code.front().getLexeme())
+    {
+    case LEX_IF: case LEX_WHILE: case LEX_DO: case LEX_RETURN:
+        return live[nodeId];
 
-    case LEX_NUM:
-        if (currToken.getValue() - (int) currToken.getValue() == 0)
+    case LEX_FOR:
+        before = transferReads(getTemplate(TMPL_FOR_INIT, node), live[nodeId], true, positions);
+        iterBefore = transferReads(getTemplate(TMPL_FOR_ITER, node), live[nodeId], true, positions);
+        before.insert(iterBefore.begin(), iterBefore.end());
+        return before;
+
+    default:
+        return transferReads(getTemplate(TMPL_STATEMENT, node), live[nodeId], false, positions);
+    }
+}
+
+// Compute the backward data-dependence slice of the branch conditions and return values over the CFG,
+// and drop the updates of the variables no later condition or return value reads from the statements.
+// The statements stay on the paths for coverage, and only their effect on the symbolic store is skipped
+void Solver::analyzeSlice()
+{
+    sliceAnalyzed = true;
+    std::map<unsigned, int> positions;                  // Position of a variable by the AST ID of its placeholder
+    for (int i = 0; i < sym.placeholders.size(); i++)
+    {
+        positions[sym.placeholders[i].id()] = i;
+    }
+    std::map<int, std::set<int>> live;                  // Variables needed after the code of every node
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto& entry : cfg.nodes)
         {
-            lexValue = currToken.getValue();
-            finExpr = sym.ctx.int_val(lexValue);
+            const Node& node = entry.second;
+            std::set<int> after;
+            if (node.code.front().getLexeme() == LEX_RETURN)
+            {
+                after = transferReads(getTemplate(TMPL_RETURN, node), after, true, positions);
+                std::unordered_set<unsigned> visited;
+                collectReads(getTemplate(TMPL_RETURN, node).value, positions, after, visited);
+            }
+            for (int edgeIndex = 0; edgeIndex < node.edges.size(); edgeIndex++)
+            {
+                const Edge& edge = node.edges.at(edgeIndex);
+                std::set<int> edgeReads = getLiveBefore(edge.idTarget, live, positions);
+                if (!edge.condition.empty())
+                {
+                    const ExprTemplate& tmpl = getTemplate(TMPL_CONDITION, node, edgeIndex);
+                    edgeReads = transferReads(tmpl, edgeReads, true, positions);
+                    std::unordered_set<unsigned> visited;
+                    collectReads(tmpl.value, positions, edgeReads, visited);
+                }
+                after.insert(edgeReads.begin(), edgeReads.end());
+            }
+            if (after != live[node.id])
+            {
+                live[node.id] = after;
+                changed = true;
+            }
         }
-        else
+    }
+
+    for (auto& entry : cfg.nodes)
+    {
+        lexeme type = entry.second.code.front().getLexeme();
+        if (type == LEX_IF || type == LEX_WHILE || type == LEX_DO || type == LEX_FOR || type == LEX_RETURN)
         {
-            double doubleVal = currToken.getValue();
-            int numDigits = 0;
-            while (doubleVal - (int) doubleVal != 0)
+            continue;
+        }
+        getTemplate(TMPL_STATEMENT, entry.second);
+        ExprTemplate& tmpl = templates.at(std::make_tuple((int) TMPL_STATEMENT, entry.first, 0));
+        if (tmpl.updates.empty())
+        {
+            continue;
+        }
+        const std::set<int>& needed = live[entry.first];
+        auto kept = std::remove_if(
+            tmpl.updates.begin(),
+            tmpl.updates.end(),
+            [this, &needed](const std::pair<int, expr>& update)
             {
-                doubleVal *= 10;
-                numDigits++;
+                return !needed.count(sym.varPositions.at(update.first));
             }
-            lexValue = doubleVal;
-            finExpr = sym.ctx.real_val(lexValue, std::pow(10, numDigits));
+        );
+        stats.assignmentsSliced += std::distance(kept, tmpl.updates.end());
+        tmpl.updates.erase(kept, tmpl.updates.end());
+        if (tmpl.updates.empty())
+        {
+            stats.statementsSliced++;
         }
-        break;
-
-    case LEX_TRUE:
-        finExpr = sym.ctx.bool_val(true);
-        break;
+    }
+}
 
-    case LEX_FALSE:
-        finExpr = sym.ctx.bool_val(false);
-        break;
+// Check whether the function can be explored with merged states: every node is executed at most once
+bool Solver::canMerge()
+{
+    if (!flowAnalyzed)
+    {
+        analyzeFlow();
+    }
+    return cyclicNodes.empty();
+}
 
-    case LEX_QUOTE_SINGLE:
-        currToken = getLexeme(line, currIndex, currType);
-        finExpr = sym.ctx.string_const(std::string(1, charConsts.at(currToken.getValue())).c_str());
-        getLexeme(line, currIndex, currType);
-        break;
+// Join the other state into the state with ite values, unless they differ in too many or too large values
+bool Solver::mergeInto(MergedState& state, const MergedState& other)
+{
+    std::vector<std::pair<int, expr>> mergedValues;
+    for (auto& idIndex : sym.varIds)
+    {
+        expr value = state.vars.get(idIndex);
+        expr otherValue = other.vars.get(idIndex);
+        if (eq(value, otherValue))
+        {
+            continue;
+        }
+        expr merged = ite(state.condition, value, otherValue);
+        if (mergedValues.size() == options.mergeMaxVars || countExprNodes(merged, options.mergeMaxSize) > options.mergeMaxSize)
+        {
+            return false;
+        }
+        mergedValues.push_back(std::make_pair(idIndex, merged));
+    }
+    for (auto& merged : mergedValues)
+    {
+        state.vars.set(merged.first, merged.second);
+    }
+    state.condition = state.condition || other.condition;
+    stats.statesMerged++;
+    return true;
+}
 
-    case LEX_QUOTE_DOUBLE:
-		currToken = getLexeme(line, currIndex, currType);
-		finExpr = sym.ctx.string_const(strConsts.at(currToken.getValue()).c_str());
-        getLexeme(line, currIndex, currType);
-        break;
+// Add state reaching a node, merging it into the first state it can be joined with
+void Solver::addMergedState(std::vector<MergedState>& states, const MergedState& newState)
+{
+    for (auto& state : states)
+    {
+        if (mergeInto(state, newState))
+        {
+            return;
+        }
+    }
+    states.push_back(newState);
+}
 
-    default:
-        break;
+// Order the nodes reachable from the entry so that every node follows all its predecessors
+std::vector<int> Solver::getTopologicalOrder()
+{
+    std::map<int, int> inDegree;
+    std::vector<int> stack{ cfg.idEntry };
+    std::set<int> reached{ cfg.idEntry };
+    while (!stack.empty())
+    {
+        int id = stack.back();
+        stack.pop_back();
+        for (auto& edge : cfg.nodes.at(id).edges)
+        {
+            inDegree[edge.idTarget]++;
+            if (cfg.nodes.count(edge.idTarget) && reached.insert(edge.idTarget).second)
+            {
+                stack.push_back(edge.idTarget);
+            }
+        }
     }
-    if (currIndex < line.size())
+
+    std::vector<int> order;
+    std::vector<int> ready{ cfg.idEntry };
+    while (!ready.empty())
     {
-        getLexeme(line, currIndex, currType);
+        int id = ready.back();
+        ready.pop_back();
+        order.push_back(id);
+        for (auto& edge : cfg.nodes.at(id).edges)
+        {
+            if (--inDegree[edge.idTarget] == 0 && cfg.nodes.count(edge.idTarget))
+            {
+                ready.push_back(edge.idTarget);
+            }
+        }
     }
-    return finExpr;
+    return order;
 }
 
-// Get all possible paths in a loop
-void Solver::getAllLoopPaths(vector<Path>& loopPaths, CFG& cfg, int currNodeId, int loopStartNodeId, Path currPath)
+// Follow the function from the entry with the inputs of the model. Returns the path taken
+Path Solver::replayModel(const model& m, expr& returnVal)
 {
-    Node currNode = cfg.nodes[currNodeId];
-    currPath.push_back(currNode);
-
-    for (auto& edge : currNode.edges)
+    Path path;
+    sym.resetVars();
+    int id = cfg.idEntry;
+    while (id >= 0)
     {
-        if (edge.idTarget != loopStartNodeId)
+        const Node& node = cfg.nodes.at(id);
+        path.push_back(node);
+        lexeme type = node.code.front().getLexeme();
+        if (type == LEX_RETURN)
         {
-            getAllLoopPaths(loopPaths, cfg, edge.idTarget, loopStartNodeId, currPath);
+            returnVal = applyTemplate(getTemplate(TMPL_RETURN, node));
         }
-        else
+        else if (type != LEX_IF)
         {
-            loopPaths.push_back(currPath);
+            applyStatement(TMPL_STATEMENT, node);
+        }
+
+        PersistentStore afterNode = sym.vars;
+        id = -1;
+        for (int edgeIndex = 0; edgeIndex < node.edges.size(); edgeIndex++)
+        {
+            const Edge& edge = node.edges.at(edgeIndex);
+            sym.vars = afterNode;
+            if (edge.condition.empty() || m.eval(applyCondition(node, edgeIndex), true).is_true())
+            {
+                id = cfg.nodes.count(edge.idTarget) ? edge.idTarget : -1;
+                break;
+            }
         }
     }
+    return path;
 }
 
-bool Solver::checkLoopBody(Path body, z3::solver& solver)
+// Execute the loop-free function once over all paths, joining the states at every node they meet in.
+// Each node and edge then costs one query for the disjunction of the conditions reaching it,
+// and a model of it is replayed into the path and test case covering it
+void Solver::exploreMergedStates(solver& solver, bool debug)
 {
-    solver.push();
-    evaluatePathConstraints(body, solver);
-    auto isSat = solver.check() == sat;
-    solver.pop();
-    return isSat;
+    std::vector<int> order = getTopologicalOrder();
+    std::map<int, std::vector<MergedState>> incoming;
+    std::map<int, expr> nodeReach;
+    std::map<std::pair<int, int>, expr> edgeReach;
+    std::vector<std::pair<int, int>> targets;           // Nodes as (id, -1) and edges as (from, to)
+    sym.resetVars();
+    incoming[cfg.idEntry].push_back(MergedState(sym.ctx->bool_val(true), sym.vars));
+    for (auto& id : order)
+    {
+        if (deadNodes.count(id))
+        {
+            continue;
+        }
+        const Node& node = cfg.nodes.at(id);
+        const std::vector<MergedState>& states = incoming[id];
+        expr reach = sym.ctx->bool_val(false);
+        for (auto& state : states)
+        {
+            reach = reach || state.condition;
+        }
+        nodeReach.emplace(id, reach);
+        targets.push_back(std::make_pair(id, -1));
+
+        lexeme type = node.code.front().getLexeme();
+        for (auto& state : states)
+        {
+            sym.vars = state.vars;
+            if (type != LEX_IF && type != LEX_RETURN)
+            {
+                applyStatement(TMPL_STATEMENT, node);
+            }
+            PersistentStore afterNode = sym.vars;
+            for (int edgeIndex = 0; edgeIndex < node.edges.size(); edgeIndex++)
+            {
+                const Edge& edge = node.edges.at(edgeIndex);
+                if (!cfg.nodes.count(edge.idTarget) || isDeadEdge(id, edgeIndex))
+                {
+                    continue;
+                }
+                sym.vars = afterNode;
+                expr cndExpr = state.condition;
+                if (!edge.condition.empty())
+                {
+                    cndExpr = cndExpr && applyCondition(node, edgeIndex);
+                }
+                addMergedState(incoming[edge.idTarget], MergedState(cndExpr, sym.vars));
+
+                auto key = std::make_pair(id, edge.idTarget);
+                auto it = edgeReach.find(key);
+                if (it == edgeReach.end())
+                {
+                    edgeReach.emplace(key, cndExpr);
+                    targets.push_back(key);
+                }
+                else
+                {
+                    it->second = it->second || cndExpr;
+                }
+            }
+        }
+        incoming.erase(id);
+    }
+
+    vector<Identifier> inputVars;
+    vector<int> inputIndices;
+    getInputs(inputVars, inputIndices);
+    for (auto& target : targets)
+    {
+        bool isNode = target.second < 0;
+        if (isCovered(target) || (isNode ? options.goal == GOAL_BRANCHES : options.goal == GOAL_STATEMENTS))
+        {
+            continue;
+        }
+        expr reach = isNode ? nodeReach.at(target.first) : edgeReach.at(target);
+        currNodeId = target.first;
+
+        pushScope(solver);
+        addConstraint(solver, reach);
+        model m(*sym.ctx);
+        queryUnknown = false;
+        bool isSat = solveClusters(solver, m);
+        popScope(solver);
+        if (debug)
+        {
+            std::cout << "Target: " << (isNode ? "node " : "edge ") << target.first;
+            if (!isNode)
+            {
+                std::cout << " -> " << target.second;
+            }
+            std::cout << "\n  Result: " << (isSat ? "reachable" : queryUnknown ? "unknown" : "unreachable") << "\n";
+        }
+        if (!isSat)
+        {
+            if (queryUnknown)
+            {
+                undecidedNodes.insert(target.first);
+                undecidedNodes.insert(target.second);
+            }
+            continue;
+        }
+
+        expr returnVal = sym.ctx->int_val(DEFAULT_NUM_VALUE);
+        Path path = replayModel(m, returnVal);
+        expr_vector evalVec(*sym.ctx);
+        evaluateModel(m, inputIndices, evalVec, returnVal);
+        paths.push_back(path);
+        testSuite.push_back(TestCase(testStore, evalVec, returnVal));
+        markCovered(path);
+        if (debug)
+        {
+            std::cout << "  Path: ";
+            for (auto& node : path)
+            {
+                std::cout << node.id << " ";
+            }
+            std::cout << "\n\n";
+        }
+    }
 }
 
-void Solver::checkUnaryOperation(const std::vector<Token>& line, int& currIndex, lexeme& currType, int idValue)
+// Find the nodes of every loop by its header node ID: the header and the nodes
+// reaching one of its back edges without passing through it
+std::map<int, std::set<int>> Solver::findLoopBodies()
 {
-    if (currIndex < line.size())
+    std::map<int, std::vector<int>> predecessors;
+    for (auto& entry : cfg.nodes)
     {
-        getLexeme(line, currIndex, currType);
-        if (currType == LEX_PLUS_PLUS || currType == LEX_MINUS_MINUS)
+        for (auto& edge : entry.second.edges)
         {
-            unaryOpTable.push_back(std::make_pair(idValue, currType));
+            predecessors[edge.idTarget].push_back(entry.first);
+        }
+    }
+
+    std::map<int, std::set<int>> loopBodies;
+    std::vector<std::pair<int, int>> stack{ std::make_pair(cfg.idEntry, 0) };   // Nodes with their next edge to visit
+    std::set<int> onStack{ cfg.idEntry };
+    std::set<int> visited{ cfg.idEntry };
+    while (!stack.empty())
+    {
+        int id = stack.back().first;
+        int edgeIndex = stack.back().second++;
+        const Node& node = cfg.nodes.at(id);
+        if (edgeIndex == node.edges.size())
+        {
+            onStack.erase(id);
+            stack.pop_back();
+            continue;
+        }
+        int target = node.edges.at(edgeIndex).idTarget;
+        if (onStack.count(target))
+        {
+            std::set<int>& body = loopBodies[target];
+            body.insert(target);
+            std::vector<int> work{ id };
+            while (!work.empty())
+            {
+                int curr = work.back();
+                work.pop_back();
+                if (body.insert(curr).second)
+                {
+                    work.insert(work.end(), predecessors[curr].begin(), predecessors[curr].end());
+                }
+            }
         }
-        else
+        else if (cfg.nodes.count(target) && visited.insert(target).second)
         {
-            ungetLexeme(line, currIndex, currType);
+            stack.push_back(std::make_pair(target, 0));
+            onStack.insert(target);
         }
     }
+    return loopBodies;
 }
 
-void Solver::executeUnaryOperations()
+// Copy the nodes of every loop once per iteration, up to options.unrollBound iterations.
+// The unrolled CFG is acyclic; order receives its copies topologically sorted
+std::vector<UnrolledNode> Solver::unrollCFG(std::vector<int>& order)
 {
-    for (auto& entry : unaryOpTable)
+    std::map<int, std::set<int>> loopBodies = findLoopBodies();
+    std::map<int, int> entryIters;
+    if (loopBodies.count(cfg.idEntry))
     {
-        int idVal = entry.first;
-        lexeme unaryOpType = entry.second;
-        expr unaryOpResult = unaryOpType == LEX_PLUS_PLUS ?
-            sym.getExpr(idVal) + sym.ctx.int_val(1) :
-            sym.getExpr(idVal) - sym.ctx.int_val(1);
-        sym.setExpr(idVal, unaryOpResult);
+        entryIters[cfg.idEntry] = 1;
     }
-    unaryOpTable.clear();
-}
-
-Solver::Solver(
-    CFG currCfg, 
-    std::vector<Identifier> ids,
-    std::vector<char> charConsts,
-    std::vector<string> strConsts,
-    int maxIter
-) : cfg(currCfg), maxIterForLoops(maxIter), ids(ids), strConsts(strConsts), charConsts(charConsts)
-{
-    sym.importVars(ids);
-}
+    std::vector<UnrolledNode> unrolled{ UnrolledNode(cfg.idEntry, entryIters) };
+    std::map<std::pair<int, std::map<int, int>>, int> copyIndices{ { std::make_pair(cfg.idEntry, entryIters), 0 } };
+    std::vector<int> inDegree{ 0 };
+    std::vector<int> stack{ 0 };
+    while (!stack.empty())
+    {
+        int index = stack.back();
+        stack.pop_back();
+        int nodeId = unrolled.at(index).nodeId;
+        std::map<int, int> loopIters = unrolled.at(index).loopIters;
+        const Node& node = cfg.nodes.at(nodeId);
+        for (int edgeIndex = 0; edgeIndex < node.edges.size(); edgeIndex++)
+        {
+            int target = node.edges.at(edgeIndex).idTarget;
+            if (!cfg.nodes.count(target) || isDeadEdge(nodeId, edgeIndex))
+            {
+                continue;
+            }
 
-void Solver::setMaxIterForLoops(int newMaxIter)
-{
-    maxIterForLoops = newMaxIter;
-}
+            // Leaving a loop forgets its iteration, entering a loop header starts or advances it
+            std::map<int, int> targetIters;
+            for (auto& loop : loopIters)
+            {
+                if (loopBodies.at(loop.first).count(target))
+                {
+                    targetIters.insert(loop);
+                }
+            }
+            if (loopBodies.count(target))
+            {
+                auto it = targetIters.find(target);
+                if (it == targetIters.end())
+                {
+                    targetIters[target] = 1;
+                }
+                else if (++it->second > options.unrollBound + 1)
+                {
+                    unrolled.at(index).cutEdges.push_back(edgeIndex);
+                    continue;
+                }
+            }
 
-bool identicalPaths(const Path& path1, const Path& path2)
-{
-    if (path1.size() != path2.size())
-    {
-        return false;
+            auto key = std::make_pair(target, targetIters);
+            auto it = copyIndices.find(key);
+            if (it == copyIndices.end())
+            {
+                it = copyIndices.emplace(key, unrolled.size()).first;
+                unrolled.push_back(UnrolledNode(target, targetIters));
+                inDegree.push_back(0);
+                stack.push_back(it->second);
+            }
+            unrolled.at(index).successors.push_back(std::make_pair(it->second, edgeIndex));
+            inDegree.at(it->second)++;
+        }
     }
-    for (int i = 0; i < path1.size(); i++)
+
+    std::vector<int> ready{ 0 };
+    while (!ready.empty())
     {
-        if (path1.at(i).id != path2.at(i).id)
+        int index = ready.back();
+        ready.pop_back();
+        order.push_back(index);
+        for (auto& successor : unrolled.at(index).successors)
         {
-            return false;
+            if (--inDegree.at(successor.first) == 0)
+            {
+                ready.push_back(successor.first);
+            }
         }
     }
-    return true;
+    return unrolled;
 }
 
+// Give the variable a fresh SSA constant defined as the value
+void Solver::defineValue(solver& solver, int idIndex, const expr& value, const std::string& suffix)
+{
+    std::string name = ids.at(idIndex).getName() + suffix;
+    expr constant = sym.ctx->constant(name.c_str(), value.get_sort());
+    solver.add(constant == value);
+    sym.setExpr(idIndex, constant);
+}
 
-TestCase Solver::evaluatePathConstraints(const Path& path, solver& solver, bool debugPrint)
+// Encode the unrolled CFG in SSA form as one formula with a reachability Boolean per node copy.
+// Every node and edge not covered yet is one check of the formula assuming it is reached,
+// and the copies reached in the model give the covered path. Executions longer than the bound are excluded
+void Solver::checkUnrolledCFG(bool debug)
 {
-    expr returnVal = sym.ctx.int_val(DEFAULT_NUM_VALUE);
-    for (int i = 0; i < path.size(); i++)
-    {
-        auto node = path[i];
-        Node nextNode;
+    std::vector<int> order;
+    std::vector<UnrolledNode> unrolled = unrollCFG(order);
+    stats.unrolledNodes = unrolled.size();
 
-        CodeLine nestedVar;
-        CodeLine iteration;
+    solver bmcSolver = createSolver();
+    std::vector<std::vector<std::pair<expr, PersistentStore>>> incoming(unrolled.size());
+    std::vector<std::vector<expr>> guards(unrolled.size());
+    std::vector<expr> returnVals(unrolled.size(), sym.ctx->int_val(DEFAULT_NUM_VALUE));
+    std::map<std::pair<int, int>, expr> targetReach;    // Nodes as (id, -1) and edges as (from, to)
+    std::vector<std::pair<int, int>> targets;
+    expr bounded = sym.ctx->bool_const("bounded");      // Guards the assertions on the cut edges
+    expr_vector cutReach(*sym.ctx);
+    sym.resetVars();
+    incoming.at(0).push_back(std::make_pair(sym.ctx->bool_val(true), sym.vars));
+    for (auto& index : order)
+    {
+        const UnrolledNode& copy = unrolled.at(index);
+        const Node& node = cfg.nodes.at(copy.nodeId);
+        const std::vector<std::pair<expr, PersistentStore>>& states = incoming.at(index);
+        std::string suffix = "!" + std::to_string(index);
 
-        int index = 0;
-        lexeme type;
-        int loopStartNodeId;
-        int loopEndIndex;
-        Path::const_iterator pathIt;
-        CodeLine::const_iterator codeIt;
+        expr_vector incomingGuards(*sym.ctx);
+        for (auto& state : states)
+        {
+            incomingGuards.push_back(state.first);
+        }
+        expr reach = sym.ctx->bool_const(("reach" + suffix).c_str());
+        bmcSolver.add(reach == mk_or(incomingGuards));
 
-        getLexeme(node.code, index, type);
-        switch (type)
+        // Join the values the incoming edges disagree on
+        sym.vars = states.front().second;
+        for (auto& idIndex : sym.varIds)
         {
-        case LEX_IF:
-            if (i == path.size() - 1)
+            expr value = states.back().second.get(idIndex);
+            bool differs = false;
+            for (auto& state : states)
             {
-                auto cnd = node.edges.back().condition;
-                expr cndExpr = solveCondition(cnd);
-                if (node.edges.size() == 1)
-                {
-                    cndExpr = !cndExpr;
-                }
-                solver.add(cndExpr);
+                differs = differs || !eq(state.second.get(idIndex), value);
             }
-            else
+            if (differs)
             {
-                nextNode = path.at(i + 1);
-                for (auto& edge : node.edges)
+                for (int k = states.size() - 2; k >= 0; k--)
                 {
-                    if (edge.idTarget == nextNode.id)
-                    {
-                        // Condition parser
-                        auto cnd = edge.condition;
-                        expr cndExpr = solveCondition(cnd);
-                        solver.add(cndExpr);
-                    }
+                    value = ite(states.at(k).first, states.at(k).second.get(idIndex), value);
                 }
+                defineValue(bmcSolver, idIndex, value, suffix);
             }
-            break;
+        }
 
-        case LEX_DO:
+        PersistentStore joined = sym.vars;
+        switch (node.code.front().getLexeme())
+        {
+        case LEX_IF: case LEX_WHILE: case LEX_DO:
             break;
 
-        case LEX_WHILE:
-            solveLoop(path, solver, i);
+        case LEX_FOR:
+            applyStatement(copy.loopIters.at(copy.nodeId) == 1 ? TMPL_FOR_INIT : TMPL_FOR_ITER, node);
             break;
 
-        case LEX_FOR:
-            nestedVar = {};
-            iteration = {};
+        case LEX_RETURN:
+            returnVals.at(index) = applyTemplate(getTemplate(TMPL_RETURN, node));
+            break;
 
-            index++;
-            while (node.code.at(index).getLexeme() != LEX_SEMICOLON)
-            {
-                nestedVar.push_back(node.code.at(index));
-                index++;
-            }
-            index++;
-            while (node.code.at(index).getLexeme() != LEX_RIGHT_PAREN)
+        default:
+            applyStatement(TMPL_STATEMENT, node);
+            break;
+        }
+        for (auto& idIndex : sym.varIds)
+        {
+            if (!eq(sym.getExpr(idIndex), joined.get(idIndex)))
             {
-                iteration.push_back(node.code.at(index));
-                index++;
+                defineValue(bmcSolver, idIndex, sym.getExpr(idIndex), suffix + "'");
             }
+        }
 
-            if (!nestedVar.empty())
+        std::vector<std::pair<std::pair<int, int>, expr>> reached{ std::make_pair(std::make_pair(copy.nodeId, -1), reach) };
+        PersistentStore afterNode = sym.vars;
+        for (auto& successor : copy.successors)
+        {
+            sym.vars = afterNode;
+            const Edge& edge = node.edges.at(successor.second);
+            expr guard = reach;
+            if (!edge.condition.empty())
             {
-                int nestedVarIndex = 0;
-                auto nestedVarType = LEX_NULL;
-                solveAssign(nestedVar, nestedVarIndex, nestedVarType);
+                guard = guard && applyCondition(node, successor.second);
             }
+            guards.at(index).push_back(guard);
+            incoming.at(successor.first).push_back(std::make_pair(guard, sym.vars));
+            reached.push_back(std::make_pair(std::make_pair(copy.nodeId, edge.idTarget), guard));
+        }
 
-            loopStartNodeId = node.id;
-            loopEndIndex = 0;
-            pathIt = std::find_if(
-                path.begin() + i + 1,
-                path.end(),
-                [loopStartNodeId](Node node)
-                {
-                    return node.id == loopStartNodeId;
-                }
-            );
-            if (pathIt != path.end())
+        // Executions must end within the bound to give complete test cases
+        for (auto& edgeIndex : copy.cutEdges)
+        {
+            sym.vars = afterNode;
+            cutReach.push_back(reach && applyCondition(node, edgeIndex));
+            bmcSolver.add(implies(bounded, !cutReach.back()));
+        }
+        for (auto& target : reached)
+        {
+            auto it = targetReach.find(target.first);
+            if (it == targetReach.end())
             {
-                loopEndIndex = distance(path.begin(), pathIt);
+                targetReach.emplace(target.first, target.second);
+                targets.push_back(target.first);
             }
-            if (loopEndIndex > 0)
+            else
             {
-                int loopIter = 0;
-                auto cnd = node.edges.front().condition;
-                expr cndExpr = solveCondition(cnd);
-
-                solver.push();          // save current state of the solver
-                solver.add(cndExpr);    // add temporary expression
-                bool loopCondSat = solver.check() == sat;
-                solver.pop();           // erase temporary expression
-
-                Path loopBodyPath{};
-                for (int k = i + 1; k < loopEndIndex; k++)
-                {
-                    loopBodyPath.push_back(path[k]);
-                }
-                i = loopEndIndex;
-
-				bool requiredPathIsFeasible = false;
-
-				// Get all possible paths in the loop body
-                vector<Path> loopPaths{};
-                getAllLoopPaths(loopPaths, cfg, loopStartNodeId + 1, loopStartNodeId);
-                while (loopIter < maxIterForLoops && loopCondSat)
-                {
-					bool pathIsFeasible = checkLoopBody(loopBodyPath, solver);
-                    if (pathIsFeasible)
-                    {
-						requiredPathIsFeasible = true;
-                        evaluatePathConstraints(loopBodyPath, solver);
-
-                        // Increment
-                        if (!iteration.empty())
-                        {
-                            solveStatement(iteration, solver);
-                        }
-
-                        cndExpr = solveCondition(cnd);
-                        solver.push();
-                        solver.add(cndExpr);
-                        loopCondSat = solver.check() == sat;
-                        solver.pop();
-                    }
-                    else
-                    {
-                        int i = 0;
-                        while (i < loopPaths.size() && !pathIsFeasible)
-                        {
-							pathIsFeasible = checkLoopBody(loopPaths.at(i), solver);
-                            i++;
-                        }
-                        evaluatePathConstraints(loopPaths.at(i - 1), solver);
-                        
-                        // Increment
-                        if (!iteration.empty())
-                        {
-                            solveStatement(iteration, solver);
-                        }
-
-                        cndExpr = solveCondition(cnd);
-                        solver.push();
-                        solver.add(cndExpr);
-                        loopCondSat = solver.check() == sat;
-                        solver.pop();
-					}
-                    loopIter++;
-                }
+                it->second = it->second || target.second;
+            }
+        }
+        incoming.at(index).clear();
+    }
 
-                /*
-                while (loopIter < maxIterForLoops && loopCondSat)
-                {
-                    evaluatePathConstraints(loopBodyPath, solver);
+    vector<Identifier> inputVars;
+    vector<int> inputIndices;
+    getInputs(inputVars, inputIndices);
+    check_result exceedsBound = cutReach.empty() ? unsat : unknown;     // Whether an execution leaves the bound
+    for (auto& target : targets)
+    {
+        bool isNode = target.second < 0;
+        if (isCovered(target) || (isNode ? options.goal == GOAL_BRANCHES : options.goal == GOAL_STATEMENTS))
+        {
+            continue;
+        }
+        std::string name = "target!" + std::to_string(target.first) + "!" + std::to_string(target.second);
+        expr literal = sym.ctx->bool_const(name.c_str());
+        bmcSolver.add(literal == targetReach.at(target));
+        expr_vector assumptions(*sym.ctx);
+        assumptions.push_back(literal);
+        assumptions.push_back(bounded);
+        stats.checkCalls++;
+        check_result result = unknown;
+        model m(*sym.ctx);
+        if (withinBudget())
+        {
+            stats.queriesSent++;
+            currNodeId = target.first;
+            result = checkWithPortfolio(bmcSolver, assumptions, m);
+        }
 
-                    if (!iteration.empty())
-                    {
-                        int iterIndex = 0;
-                        auto iterType = LEX_NULL;
-
-                        codeIt = std::find_if(
-                            iteration.begin(),
-                            iteration.end(),
-                            [](Token lex)
-                            {
-                                return (lex.getLexeme() == LEX_ASSIGN || lex.getLexeme() >= LEX_PLUS_ASSIGN && lex.getLexeme() <= LEX_SLASH_ASSIGN);
-                            }
-                        );
-                        if (codeIt != iteration.end())
-                        {
-                            solveAssign(iteration, iterIndex, iterType);
-                        }
-                        else
-                        {
-                            EXPR(iteration, iterIndex, iterType);
-                        }
-                    }
+        // An unsat target is only dead when no execution leaves the bound
+        if (result == unsat && exceedsBound == unknown && withinBudget())
+        {
+            expr_vector unbounded(*sym.ctx);
+            unbounded.push_back(!bounded);
+            unbounded.push_back(mk_or(cutReach));
+            model ignored(*sym.ctx);
+            stats.checkCalls++;
+            stats.queriesSent++;
+            exceedsBound = checkWithPortfolio(bmcSolver, unbounded, ignored);
+        }
+        if (result == unsat && exceedsBound != unsat)
+        {
+            result = unknown;
+        }
+        if (result == unknown)
+        {
+            stats.queriesUnknown++;
+            undecidedNodes.insert(target.first);
+            undecidedNodes.insert(target.second);
+        }
+        bool isSat = result == sat;
+        if (debug)
+        {
+            std::cout << "Target: " << (isNode ? "node " : "edge ") << target.first;
+            if (!isNode)
+            {
+                std::cout << " -> " << target.second;
+            }
+            std::cout << "\n  Result: " << (isSat ? "reachable" : result == unknown ? "unknown within the bound" : "unreachable") << "\n";
+        }
+        if (!isSat)
+        {
+            continue;
+        }
 
-                    cndExpr = solveCondition(cnd);
-                    solver.push();
-                    solver.add(cndExpr);
-                    loopCondSat = solver.check() == sat;
-                    solver.pop();
-                    loopIter++;
-                }
-                */
-                if (loopIter == maxIterForLoops || !requiredPathIsFeasible)
+        // Follow the node copies the model reaches from the entry
+        Path path;
+        expr returnVal = sym.ctx->int_val(DEFAULT_NUM_VALUE);
+        int index = 0;
+        while (index >= 0)
+        {
+            const UnrolledNode& copy = unrolled.at(index);
+            path.push_back(cfg.nodes.at(copy.nodeId));
+            if (path.back().code.front().getLexeme() == LEX_RETURN)
+            {
+                returnVal = returnVals.at(index);
+            }
+            int next = -1;
+            for (int k = 0; k < copy.successors.size() && next < 0; k++)
+            {
+                if (m.eval(guards.at(index).at(k), true).is_true())
                 {
-                    solver.add(sym.ctx.bool_val(false));
+                    next = copy.successors.at(k).first;
                 }
             }
-            else
+            index = next;
+        }
+
+        expr_vector evalVec(*sym.ctx);
+        evaluateModel(m, inputIndices, evalVec, returnVal);
+        paths.push_back(path);
+        testSuite.push_back(TestCase(testStore, evalVec, returnVal));
+        markCovered(path);
+        if (debug)
+        {
+            std::cout << "  Path: ";
+            for (auto& node : path)
             {
-                auto cnd = node.edges.back().condition;
-                expr cndExpr = solveCondition(cnd);
-                solver.add(cndExpr);
+                std::cout << node.id << " ";
             }
-            break;
+            std::cout << "\n\n";
+        }
+    }
+}
 
-        case LEX_RETURN:
-            returnVal = EXPR(node.code, index, type);
-            break;
+void Solver::checkAllPaths(bool debug = false)
+{
+    startTime = std::chrono::steady_clock::now();
+    initCoverage();
+    if (options.intervalAnalysis && !intervalsAnalyzed)
+    {
+        analyzeIntervals();
+    }
+    if (options.engine == ENGINE_BMC)
+    {
+        checkUnrolledCFG(debug);
+        return;
+    }
+    if (options.mergeStates && canMerge())
+    {
+        solver z3Solver = createSolver();
+        exploreMergedStates(z3Solver, debug);
+        return;
+    }
 
-        default:
-			solveStatement(node.code, solver);
-            break;
-        }
-        
-        if (solver.check() == unsat)
-        {
-            return TestCase();
-		}
+    collectPaths(cfg.idEntry, {}, {}, {});
+    if (debug)
+    {
+        debugPrintPaths();
     }
-    bool isSat = solver.check() == sat;
 
-    expr_vector varsVec(sym.ctx);
-    expr_vector evalVec(sym.ctx);
-    
-    if (isSat)
+    // Paths are collected depth-first, so consecutive paths share prefixes.
+    // Each path resumes from the state saved where it leaves the previous one.
+    // With a coverage goal, only paths through uncovered targets are evaluated
+    solver z3Solver = createSolver();
+    checkpoints.clear();
+    prevPath = {};
+    testSuite.assign(paths.size(), TestCase());
+    std::vector<std::set<int>> cutLoops(paths.size()); // Loops whose bound made each path infeasible
+    std::vector<bool> evaluated(paths.size(), false);
+    int budget = options.pathBudget > 0 ? options.pathBudget : -1;
+    int next = selectNextPath(evaluated);
+    while (next >= 0 && budget != 0 && withinBudget())
     {
-        for (int i = 0; i < solver.get_model().size(); i++)
+        evaluated.at(next) = true;
+        budget--;
+        currPathId = next;
+        testSuite.at(next) = evaluatePathConstraints(paths.at(next), z3Solver, debug);
+        cutLoops.at(next) = loopsAtBound;
+        if (testSuite.at(next).isFeasible())
         {
-            expr eval = solver.get_model().eval(sym.vars.at(i).second, true);
-            varsVec.push_back(sym.vars.at(i).second);
-            evalVec.push_back(eval);
-
+            markCovered(paths.at(next));
         }
-        returnVal = returnVal.substitute(varsVec, evalVec);
+        pathsInContext++;
+        if (isRecycleDue())
+        {
+            recycleContext(z3Solver);
+        }
+        next = selectNextPath(evaluated);
     }
-
-    // Print feasibility results
-    if (debugPrint)
+    for (int i = 0; i < paths.size(); i++)
     {
-        std::cout << "Path: ";
-        for (auto line : path)
+        // If the budget ran out, the paths left through uncovered targets are undecided
+        int distance;
+        if (evaluated.at(i))
         {
-            std::cout << line.id << " ";
+            continue;
         }
-        std::cout << "\n  Result: " << (isSat ? "feasible" : "infeasible") << "\n";
-
-        if (isSat)
+        if (next >= 0 && countUncovered(paths.at(i), distance) > 0)
         {
-            std::cout << "  Test case:\n";
-            for (int i = 0; i < evalVec.size(); i++)
-            {
-                string evalStr = evalVec[i].to_string();
-                std::cout << "    " << ids.at(i + 1).getName() << " = " << evalStr << "\n";
-            }
-            std::cout << "  Return value: " << returnVal.simplify() << "\n";
+            markUndecided(paths.at(i));
+        }
+        else
+        {
+            stats.pathsSkipped++;
         }
-        cout << "\n";
     }
 
-    if (isSat)
+    // Loops start with a small bound. A path cut off by a bound is evaluated again
+    // with deeper bounds while it still leads through an uncovered target
+    bool deepened = true;
+    while (deepened && budget != 0 && withinBudget())
     {
-        vector<Identifier> inputVars;
-        for (auto& id : ids)
+        deepened = false;
+        for (int i = 0; i < paths.size() && budget != 0 && withinBudget(); i++)
         {
-            if (id.getIdType() == INPUT_VAR)
+            int distance;
+            if (testSuite.at(i).isFeasible() || cutLoops.at(i).empty() ||
+                countUncovered(paths.at(i), distance) == 0 || !deepenLoopBounds(cutLoops.at(i)))
+            {
+                continue;
+            }
+            deepened = true;
+            budget--;
+            prevPath = {};                              // checkpoints hold states computed with the old bounds
+            testSuite.at(i) = evaluatePathConstraints(paths.at(i), z3Solver, debug);
+            cutLoops.at(i) = loopsAtBound;
+            if (testSuite.at(i).isFeasible())
+            {
+                markCovered(paths.at(i));
+            }
+            pathsInContext++;
+            if (isRecycleDue())
             {
-                inputVars.push_back(id);
+                recycleContext(z3Solver);
             }
         }
-        return TestCase(
-            inputVars,
-            evalVec,
-            returnVal
-        );
     }
-    return TestCase();
 }
 
-void Solver::debugPrintPaths()
+// Get the uncovered nodes whose reachability was left unknown by a timeout or the budget
+std::set<int> Solver::getUnknownNodes() const
 {
-    cout << "PATHS COLLECTED\n";
-    int i = 1;
-    for (auto& path : paths)
+    std::set<int> unknownNodes;
+    for (auto& id : undecidedNodes)
     {
-        cout << "Path " << i << ":\n   ";
-        for (auto& node : path)
+        if (id >= 0 && id < nodeCoverage.size() && !nodeCoverage.at(id))
         {
-            cout << node.id << " ";
+            unknownNodes.insert(id);
         }
-        cout << "\n";
-        i++;
     }
-    cout << "\n";
+    return unknownNodes;
 }
 
-void Solver::checkAllPaths(bool debug = false)
+// Check whether the search stopped at the budget
+bool Solver::isBudgetExhausted() const
 {
-    collectPaths(cfg.idEntry, {}, {});
-    if (debug)
-    {
-        debugPrintPaths();
-    }
-
-    for (auto& path : paths)
-    {
-        solver z3Solver(sym.ctx);
-        TestCase newTestCase = evaluatePathConstraints(path, z3Solver, debug);
-        testSuite.push_back(newTestCase);
-        sym.resetVars(ids);
-    }
+    return budgetExhausted;
 }
 
 std::vector<std::pair<Path, TestCase>> Solver::getPathsAndCases()
@@ -4,12 +4,42 @@
 #define DEFAULT_NUM_VALUE 0
 #define DEFAULT_CHAR_VALUE '\0'
 
+#define INT_BITS 32
+#define FLOAT_EBITS 8
+#define FLOAT_SBITS 24
+#define DOUBLE_EBITS 11
+#define DOUBLE_SBITS 53
+#define CHAR_BITS 8
+#define STRING_MAX_LENGTH 16
+#define DECIMAL_DIGITS 6                                // Fraction digits of printed floating-point values
+
 #include "Parser.h"
 #include "CFG.h"
+#include "PersistentStore.h"
+#include "PathCondition.h"
+#include "CounterexampleCache.h"
+#include "DiskQueryCache.h"
+#include "PreSolver.h"
+#include "IntervalAnalysis.h"
+#include "SolverPortfolio.h"
+#include "QueryCapture.h"
 #include <iostream>
 #include <vector>
 #include <string>
 #include <set>
+#include <map>
+#include <tuple>
+#include <unordered_set>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <numeric>
+#include <chrono>
+#include <memory>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
 #include <z3++.h>
 
 using namespace z3;
@@ -19,37 +49,274 @@ using Path = std::vector<Node>;
 // Symbolic environment for variables
 struct SymbolicContext
 {
-    context ctx;
-    std::vector<std::pair<int, expr>> vars;
+    std::unique_ptr<context> ctx;                       // Replaced by a fresh one when the context is recycled
+    PersistentStore vars;                               // Current values of variables, indexed by identifier ID
+    PersistentStore initVars;                           // Initial values of variables
+    std::vector<int> varIds;                            // Identifier IDs of the variables
+    std::map<int, int> varPositions;                    // Position of each variable in varIds
+    std::map<unsigned, int> initVarIds;                 // Identifier ID of each initial value by its AST ID
+    expr_vector placeholders;                           // Parameters of compiled templates, in the order of varIds
+    bool machineArithmetic;                             // Variables have bit-vector and floating-point sorts
+    bool stringTheory;                                  // char and char* variables are Z3 strings
 
-    SymbolicContext();
+    SymbolicContext(std::unique_ptr<context> ctx = nullptr);
 
     void importVars(vector<Identifier> ids);
-    void resetVars(vector<Identifier> ids);
-
-    int getIndex(int val) const;
+    void resetVars();
+    std::unique_ptr<context> renewContext(vector<Identifier> ids);
 
     expr getExpr(int val) const;
     void setExpr(int val, expr newExpr);
+
+    void usePlaceholders();
+    expr_vector getCurrentValues();
+
+    std::vector<int> getInputIds(const expr& e) const;
+
+    expr intVal(int value);
+    expr realVal(double value, int numerator, int denominator);
+    expr charVal(char value);
+    expr strVal(const std::string& value);
+};
+
+// Policies of querying the solver while executing a path
+enum checkPolicy
+{
+    CHECK_EVERY_NODE,                                   // After every node
+    CHECK_ON_CONSTRAINT,                                // After every node that added a constraint
+    CHECK_BATCHED                                       // After every checkBatchSize added constraints
+};
+
+// Engines searching for the test cases
+enum solverEngine
+{
+    ENGINE_PATHS,                                       // Enumerate paths and solve their path conditions
+    ENGINE_BMC                                          // Encode the CFG unrolled to a bound as one formula
+};
+
+// Coverage the solver searches test cases for
+enum coverageGoal
+{
+    GOAL_ALL_PATHS,                                     // Evaluate every collected path
+    GOAL_STATEMENTS,                                    // Stop when every reachable node is covered
+    GOAL_BRANCHES                                       // Stop when every reachable edge is covered
+};
+
+// Solver settings
+struct SolverOptions
+{
+    solverEngine engine;
+    coverageGoal goal;
+    int pathBudget;                                     // Paths evaluated at most, 0 for no limit
+    double timeBudget;                                  // Milliseconds of solving at most, 0 for no limit
+    int queryBudget;                                    // Queries sent to Z3 at most, 0 for no limit
+    int memoryBudget;                                   // Megabytes allocated by Z3 at most, 0 for no limit
+    int recyclePaths;                                   // Paths evaluated in one Z3 context before it is recycled, 0 for never
+    int recycleMemory;                                  // Megabytes allocated by Z3 that make the context recycled, 0 for never
+    unsigned queryTimeout;                              // Milliseconds Z3 may spend on one query, 0 for no limit
+    bool portfolio;                                     // Race tactic configurations on the queries the default solver cannot decide quickly
+    unsigned portfolioThreshold;                        // Milliseconds a query runs on the default solver before the race
+    checkPolicy policy;
+    int checkBatchSize;
+    bool summarizeLoops;                                // Replace affine loops with their closed form
+    int loopVisits;                                     // Visits of a loop header per collected path
+    int initialLoopBound;                               // Iterations allowed before a loop is deepened
+    int loopBoundGrowth;                                // Factor of deepening a loop bound
+    bool sliceConstraints;                              // Send only the clusters of dependent constraints
+    bool cacheQueries;                                  // Answer queries from the counterexample cache
+    bool presolve;                                      // Decide simple queries by bounds and difference bounds before Z3
+    bool intervalAnalysis;                              // Skip the edges interval analysis of the CFG proves dead
+    bool staticSlicing;                                 // Skip the assignments no condition or return value depends on
+    bool warmupContext;                                 // Create and warm up the Z3 context while the front end runs
+    bool pruneByCores;                                  // Skip paths with a known conflicting set of branches
+    int modelsPerPath;                                  // Distinct inputs found for every feasible path
+    std::string cacheDirectory;                         // Directory of the on-disk query cache, empty to disable it
+    std::string captureDirectory;                       // Directory every Z3 query is written to as SMT-LIB2, empty to disable it
+    bool machineArithmetic;                             // Model int as 32-bit bit-vectors and float, double as IEEE floating point
+    bool stringTheory;                                  // Model char and char* as Z3 strings instead of bytes
+    bool mergeStates;                                   // Explore loop-free functions with states merged at joins
+    int mergeMaxVars;                                   // Variables two states may differ in to be merged
+    int mergeMaxSize;                                   // Size of a merged value, in expression nodes, to be merged
+    int unrollBound;                                    // Iterations of every loop in the unrolled CFG
+    std::vector<std::string> tactics;                   // Tactic pipeline the solvers are built from, empty for the default solver
+    std::vector<std::pair<std::string, std::string>> z3Params;  // Z3 parameters of the solvers, like random_seed or arith.solver
+
+    SolverOptions();
+
+    bool applyPreset(const std::string& name);
+    bool load(const std::string& fileName);
+    solver createSolver(context& ctx) const;
+    static std::vector<std::string> getPresetNames();
+};
+
+// Solver counters
+struct SolverStats
+{
+    int checkCalls;                                     // Number of solver.check() calls issued
+    int checksSaved;                                    // Number of per-node checks skipped by the policy
+    int loopsSummarized;                                // Number of loops executed in one step
+    int loopsUnrolled;                                  // Number of loops executed iteration by iteration
+    int constraintsSent;                                // Number of constraints sent with the queries
+    int constraintsSliced;                              // Number of constraints left out as independent
+    int cacheHits;                                      // Number of queries answered by the cache
+    int diskCacheHits;                                  // Number of queries answered by the on-disk cache
+    int cacheMisses;                                    // Number of queries the caches could not answer
+    int queriesPresolved;                               // Number of queries decided without Z3 by the pre-solver
+    int queriesSent;                                    // Number of queries sent to Z3
+    int queriesUnknown;                                 // Number of queries left undecided by a timeout or the budget
+    int portfolioRaces;                                 // Number of queries raced on the solver portfolio
+    int queriesCaptured;                                // Number of queries written to the capture directory
+    std::map<std::string, int> portfolioWins;           // Number of races won by every configuration
+    int coresRecorded;                                  // Number of conflicting branch sets found
+    int pathsPruned;                                    // Number of paths skipped without querying Z3
+    int pathsSkipped;                                   // Number of paths left out as adding no coverage
+    int statesMerged;                                   // Number of states joined into another one
+    int unrolledNodes;                                  // Number of node copies in the unrolled CFG
+    int deadEdges;                                      // Number of edges proved dead by interval analysis
+    int deadNodes;                                      // Number of nodes proved unreachable by interval analysis
+    double analysisTime;                                // Milliseconds spent on interval analysis
+    int statementsSliced;                               // Number of statements left without effect by the static slice
+    int assignmentsSliced;                              // Number of variable updates dropped by the static slice
+    int extraModels;                                    // Number of inputs found for a path beyond its first one
+    int contextsRecycled;                               // Number of times the Z3 context was replaced by a fresh one
+    double recycleTime;                                 // Milliseconds spent migrating into fresh contexts
+
+    SolverStats();
+};
+
+// Symbolic state saved before executing a node of the path
+struct Checkpoint
+{
+    int nodeIndex;                                      // Index of the next node to execute
+    int horizon;                                        // Index of the furthest node the state depends on
+    PersistentStore vars;
+    expr returnVal;
+    std::set<int> loopsAtBound;
+
+    Checkpoint(int nodeIndex, int horizon, PersistentStore vars, expr returnVal, std::set<int> loopsAtBound);
+};
+
+// Kinds of compiled code lines
+enum templateKind
+{
+    TMPL_STATEMENT,
+    TMPL_CONDITION,
+    TMPL_RETURN,
+    TMPL_FOR_INIT,
+    TMPL_FOR_ITER
 };
 
-// Test case class
+// Code line translated once into Z3 expressions over variable placeholders
+struct ExprTemplate
+{
+    expr value;                                         // Condition or return value
+    std::vector<std::pair<int, expr>> updates;          // New values of the variables written by the line
+
+    ExprTemplate(context& ctx);
+};
+
+// Closed form of a loop whose body updates the variables affinely
+struct LoopSummary
+{
+    bool summarized;                                    // False if the loop has to be unrolled
+    ExprTemplate closedForm;                            // Trip count and values of the variables after the loop
+
+    LoopSummary(context& ctx);
+};
+
+// Symbolic state of the paths reaching a node, possibly several paths joined with ite
+struct MergedState
+{
+    expr condition;                                     // Condition under which the state is reached
+    PersistentStore vars;
+
+    MergedState(expr condition, PersistentStore vars);
+};
+
+// Copy of a CFG node in the CFG unrolled for bounded model checking
+struct UnrolledNode
+{
+    int nodeId;
+    std::map<int, int> loopIters;                       // Iteration of every enclosing loop by header node ID
+    std::vector<std::pair<int, int>> successors;        // Copies following the node, with the index of the edge to them
+    std::vector<int> cutEdges;                          // Indices of the edges exceeding the bound
+
+    UnrolledNode(int nodeId, std::map<int, int> loopIters);
+};
+
+// Kinds of test case values, by the sort of the Z3 value
+enum valueKind
+{
+    VALUE_NONE,                                         // Column without a value yet
+    VALUE_INT,                                          // Mathematical integer
+    VALUE_BITS,                                         // Machine integer
+    VALUE_RATIONAL,                                     // Real number as a fraction
+    VALUE_FLOAT,                                        // IEEE floating point
+    VALUE_BOOL,
+    VALUE_CHAR,                                         // Byte
+    VALUE_BYTES,                                        // Byte string up to its terminating zero
+    VALUE_TEXT                                          // Any other value, as Z3 prints it
+};
+
+// Input schema and values of all the test cases of a suite, shared by the test cases. Every input
+// variable and the output have a typed column, one row per input. The kind of an input column
+// follows the sort of the variable, and the output column takes the kind of its first value.
+// A value that does not fit its column is kept formatted beside it. Values are formatted only
+// when printed
+class TestSuiteStore
+{
+    struct Column
+    {
+        valueKind kind;
+        std::vector<int64_t> numbers;                   // Integers, numerators, booleans and bytes
+        std::vector<int64_t> denominators;              // Denominators of rational values
+        std::vector<double> floats;
+        std::vector<std::string> texts;                 // Byte strings and other values
+        std::unordered_map<int, std::string> irregular; // Formatted values of another kind by row
+
+        Column(valueKind kind);
+    };
+
+    std::vector<Identifier> inputs;
+    std::vector<Column> columns;                        // Input variables in the order of inputs, then the output
+    std::vector<bool> unspecified;                      // Rows whose model leaves the inputs free
+
+    void push(Column& column, int64_t number, int64_t denominator, double floating, const std::string& text);
+    void append(Column& column, const expr& value, int row);
+    std::string format(const Column& column, int row) const;
+
+public:
+    TestSuiteStore(std::vector<Identifier> inputs, const std::vector<z3::sort>& sorts);
+
+    static valueKind getKind(const z3::sort& s);
+
+    int addRow(const expr_vector& inputValues, const expr& output);
+
+    int getInputCount() const;
+    const Identifier& getInput(int index) const;
+    std::string getValue(int row, int index) const;
+    std::string getOutput(int row) const;
+};
+
+// Test case class. The values are rows of the store of the suite
 class TestCase
 {
     bool sat;
-    std::vector<Identifier> ids;
-    std::vector<string> values;
-    std::string output;
+    std::shared_ptr<TestSuiteStore> store;
+    int row;                                            // Row of the first input of the path
+    int variantCount;                                   // Other inputs taking the same path, in the rows after it
 
 public:
     TestCase();
 
     TestCase(
-        std::vector<Identifier> funcParams,
+        std::shared_ptr<TestSuiteStore> store,
         expr_vector evals,
         expr returnVar
     );
 
+    void addVariant(expr_vector evals, expr returnVar);
+
     bool isFeasible();
 
     int getSize();
@@ -59,6 +326,12 @@ public:
     string getIdValue(int index);
 
     string getOutput();
+
+    int getVariantCount();
+
+    string getVariantValue(int variant, int index);
+
+    string getVariantOutput(int variant);
 };
 
 // SMT Solver class
@@ -71,17 +344,77 @@ class Solver
     std::vector<string> strConsts;
     std::vector<Path> paths;
     std::vector<TestCase> testSuite;
+    std::shared_ptr<TestSuiteStore> testStore;          // Values of the test cases
     std::vector <std::pair<int, lexeme>> unaryOpTable;
+    std::map<std::tuple<int, int, int>, ExprTemplate> templates;
+    std::map<std::vector<int>, LoopSummary> loopSummaries;
+    std::map<int, std::vector<Path>> loopPaths;
+    std::vector<Checkpoint> checkpoints;
+    Path prevPath;
     int maxIterForLoops;
+    std::map<int, int> loopBounds;                      // Iteration bound of each unrolled loop by header node ID
+    std::set<int> loopsAtBound;                         // Loops cut off by their bound on the current path
+    SolverOptions options;
+    SolverStats stats;
+    int pendingConstraints;                             // Constraints added since the last check
+    PathCondition pathCondition;
+    std::vector<int> scopeSizes;                        // Path condition size at every solver scope
+    z3::solver sliceSolver;                             // Solver for the independent clusters
+    CounterexampleCache queryCache;
+    DiskQueryCache diskCache;
+    PreSolver preSolver;
+    SolverPortfolio portfolio;
+    QueryCapture capture;
+    int currPathId;                                     // Index of the path being evaluated, -1 outside the path search
+    int currNodeId;                                     // ID of the node whose constraints are being checked
+    int pathsInContext;                                 // Paths evaluated since the context was created
+    std::vector<std::set<std::pair<int, int>>> decisionCores;   // Sets of branch edges that cannot be taken together
+    std::set<unsigned> writtenVars;                     // Placeholders of the variables the function assigns
+    std::set<int> cyclicNodes;                          // Nodes on a cycle of the CFG
+    bool flowAnalyzed;
+    std::set<std::pair<int, int>> deadEdges;            // Node ID and edge index of the edges no execution takes
+    std::set<int> deadNodes;                            // Nodes no execution reaches
+    bool intervalsAnalyzed;
+    bool sliceAnalyzed;
+    std::vector<bool> nodeCoverage;                     // Live coverage bitmap of the nodes, indexed by node ID
+    std::vector<bool> edgeCoverage;                     // Live coverage bitmap of the edges, indexed by edgeBits
+    std::map<std::pair<int, int>, int> edgeBits;        // Bit of every edge by its source and target node IDs
+    std::chrono::steady_clock::time_point startTime;
+    bool budgetExhausted;
+    bool queryUnknown;                                  // A query of the current path or target ended undecided
+    std::set<int> undecidedNodes;                       // Nodes of the paths and targets left undecided
 
-    void collectPaths(int id, Path currPath, std::set<int> visitedNodes, int loopIterCount);
+    void collectPaths(int id, Path currPath, std::set<int> visitedNodes, std::map<int, int> loopVisits);
     Token getLexeme(const std::vector<Token>& line, int& index, lexeme& type);
     void ungetLexeme(const std::vector<Token>& line, int& index, lexeme& type);
 
-	void solveStatement(const std::vector<Token>& code, solver& solver);
+	void solveStatement(const std::vector<Token>& code);
     void solveAssign(const std::vector<Token>& code, int& index, lexeme& type);
     expr solveCondition(const std::vector<Token>& cnd);
-    void solveLoop(const Path& path, solver& solver, int& currNodeIndex);
+    bool solveLoop(const Path& path, solver& solver, int& currNodeIndex);
+
+    void pushScope(solver& solver);
+    void popScope(solver& solver, int count = 1);
+    void addConstraint(solver& solver, const expr& constraint, std::pair<int, int> decision = std::make_pair(-1, -1));
+    bool checkIsDue() const;
+    check_result checkSat(solver& solver);
+    bool checkWithConstraint(solver& solver, const expr& constraint);
+    check_result checkSlice(solver& solver, const std::vector<int>& slice, model& m);
+    check_result checkWithPortfolio(solver& solver, const expr_vector& assumptions, model& m);
+    void recordUnsatCore(const std::vector<expr>& query, const std::vector<int>& slice);
+    void analyzeFlow();
+    bool isStableDecision(const Node& node, int edgeIndex);
+    bool containsKnownCore(const Path& path);
+    bool solveClusters(solver& solver, model& merged);
+    void getInputs(std::vector<Identifier>& inputVars, std::vector<int>& inputIndices);
+    void evaluateModel(const model& m, const std::vector<int>& inputIndices, expr_vector& inputValues, expr& returnVal);
+    void findVariants(TestCase& testCase, solver& solver, const model& m, const std::vector<int>& inputIndices, const expr& returnVal);
+
+    const ExprTemplate& getTemplate(templateKind kind, const Node& node, int edgeIndex = 0);
+    ExprTemplate compileLine(templateKind kind, const Node& node, int edgeIndex);
+    expr applyTemplate(const ExprTemplate& tmpl);
+    expr applyCondition(const Node& node, int edgeIndex);
+    void applyStatement(templateKind kind, const Node& node);
 
     expr EXPR(const std::vector<Token>& line, int& currIndex, lexeme& currType);
     expr DISJ(const std::vector<Token>& line, int& currIndex, lexeme& currType);
@@ -92,18 +425,80 @@ class Solver
     expr FIN(const std::vector<Token>& line, int& currIndex, lexeme& currType);
 
     void getAllLoopPaths(vector<Path>& loopPaths, CFG& cfg, int currNodeId, int loopStartNodeId, Path currPath = {});
+    const std::vector<Path>& getLoopPaths(int loopStartNodeId);
+    expr substituteState(expr e, const std::vector<expr>& state);
+    void applyTemplateTo(const ExprTemplate& tmpl, std::vector<expr>& state);
+    const LoopSummary& getLoopSummary(const Node& loopNode, const Path& body);
+    LoopSummary summarizeLoop(const Node& loopNode, const Path& body);
+    bool applyLoopSummary(const Node& loopNode, const Path& body, solver& solver);
     bool checkLoopBody(Path body, z3::solver& solver);
+    int getLoopBound(int loopStartNodeId);
+    bool deepenLoopBounds(const std::set<int>& loops);
     void checkUnaryOperation(const std::vector<Token>& line, int& currIndex, lexeme& currType, int idValue);
     void executeUnaryOperations();
 
+    bool executePath(const Path& path, solver& solver, expr& returnVal, int startIndex = 0, bool saveCheckpoints = false);
+    int resumeFromCheckpoint(const Path& path, solver& solver, expr& returnVal);
     TestCase evaluatePathConstraints(const Path& path, solver& solver, bool debugPrint = false);
     void debugPrintPaths();
 
+    solver createSolver();
+    void setTimeout(solver& solver, unsigned timeout);
+    bool withinBudget();
+    bool isRecycleDue() const;
+    void recycleContext(solver& solver);
+
+    void initCoverage();
+    bool isCovered(std::pair<int, int> target) const;
+    void markCovered(const Path& path);
+    void markUndecided(const Path& path);
+    int countUncovered(const Path& path, int& distance) const;
+    int selectNextPath(const std::vector<bool>& evaluated) const;
+
+    std::vector<std::pair<int, expr>> getUpdatePositions(const ExprTemplate& tmpl);
+    void analyzeIntervals();
+    bool isDeadEdge(int nodeId, int edgeIndex) const;
+
+    std::set<int> transferReads(const ExprTemplate& tmpl, const std::set<int>& after, bool keepAll, const std::map<unsigned, int>& positions);
+    std::set<int> getLiveBefore(int nodeId, std::map<int, std::set<int>>& live, const std::map<unsigned, int>& positions);
+    void analyzeSlice();
+
+    bool canMerge();
+    bool mergeInto(MergedState& state, const MergedState& other);
+    void addMergedState(std::vector<MergedState>& states, const MergedState& newState);
+    std::vector<int> getTopologicalOrder();
+    Path replayModel(const model& m, expr& returnVal);
+    void exploreMergedStates(solver& solver, bool debug);
+
+    std::map<int, std::set<int>> findLoopBodies();
+    std::vector<UnrolledNode> unrollCFG(std::vector<int>& order);
+    void defineValue(solver& solver, int idIndex, const expr& value, const std::string& suffix);
+    void checkUnrolledCFG(bool debug);
+
 public:
-    Solver(CFG currCfg, std::vector<Identifier> ids, std::vector<char> charConsts, std::vector<string> strConsts, int maxIter = 10000);
+    Solver(
+        CFG currCfg,
+        std::vector<Identifier> ids,
+        std::vector<char> charConsts,
+        std::vector<string> strConsts,
+        int maxIter = 10000,
+        SolverOptions options = SolverOptions(),
+        std::unique_ptr<context> warmContext = nullptr
+    );
 
     void setMaxIterForLoops(int newMaxIter);
 
+    SolverStats getStats() const;
+
+    std::map<int, int> getLoopBounds() const;
+
+    std::set<int> getDeadNodes();
+    std::vector<std::pair<int, int>> getDeadEdges();
+
+    std::set<int> getUnknownNodes() const;
+
+    bool isBudgetExhausted() const;
+
     void checkAllPaths(bool debug);
 
     std::vector<std::pair<Path, TestCase>> getPathsAndCases();
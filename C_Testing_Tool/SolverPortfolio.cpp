@@ -0,0 +1,169 @@
+#include "SolverPortfolio.h"
+
+//.........................SOLVER PORTFOLIO CLASS
+
+// Constructor. Nonlinear integer and real arithmetic is raced against the nonlinear tactics,
+// and machine arithmetic against bit-blasting. The configurations are ordered by priority,
+// and only as many race as the hardware runs threads, but at least two
+SolverPortfolio::SolverPortfolio(context& ctx, bool bitVectors) : ctx(&ctx)
+{
+    finishedCount = 0;
+    winner = -1;
+    stopped = false;
+    configurations.push_back({ "default", "", 0 });
+    if (bitVectors)
+    {
+        configurations.push_back({ "bit-blast", "qfbv", 0 });
+        configurations.push_back({ "fp-bit-blast", "qffpbv", 0 });
+    }
+    else
+    {
+        configurations.push_back({ "qfnia", "qfnia", 0 });
+        configurations.push_back({ "nlsat", "qfnra-nlsat", 0 });
+    }
+    configurations.push_back({ "default-reseeded", "", PORTFOLIO_SEED });
+    int threads = std::max((int) std::thread::hardware_concurrency(), PORTFOLIO_MIN_WORKERS);
+    if (configurations.size() > threads)
+    {
+        configurations.resize(threads);
+    }
+}
+
+// Switch to the recycled context of the caller
+void SolverPortfolio::setContext(context& newCtx)
+{
+    ctx = &newCtx;
+}
+
+// Constructor of a worker, with the query translated into its own context
+SolverPortfolio::Worker::Worker(const expr_vector& source) : query(ctx, source), m(ctx)
+{
+    result = unknown;
+    finished = false;
+}
+
+// Solve the query of the worker with the configuration at the index. A tactic that does not apply
+// to the query fails, and the worker answers unknown
+void SolverPortfolio::run(Worker& worker, int index, unsigned timeout)
+{
+    const Configuration& config = configurations.at(index);
+    check_result result = unknown;
+    try
+    {
+        solver s = config.tactic.empty() ? solver(worker.ctx) : tactic(worker.ctx, config.tactic.c_str()).mk_solver();
+        params p(worker.ctx);
+        p.set("timeout", timeout > 0 ? timeout : UINT_MAX);
+        if (config.seed > 0)
+        {
+            p.set("random_seed", config.seed);
+        }
+        s.set(p);
+        for (int i = 0; i < worker.query.size(); i++)
+        {
+            s.add(worker.query[i]);
+        }
+        bool skip;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            skip = stopped;
+        }
+        if (!skip)
+        {
+            result = s.check();
+            if (result == sat)
+            {
+                worker.m = s.get_model();
+            }
+        }
+    }
+    catch (exception&)
+    {
+        result = unknown;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    worker.result = result;
+    worker.finished = true;
+    finishedCount++;
+    if (result != unknown && winner < 0)
+    {
+        winner = index;
+    }
+    done.notify_all();
+}
+
+// Race the configurations on the query for at most the timeout in milliseconds, 0 for no limit
+check_result SolverPortfolio::check(const std::vector<expr>& query, model& m, unsigned timeout)
+{
+    expr_vector source(*ctx);
+    for (auto& constraint : query)
+    {
+        source.push_back(constraint);
+    }
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < configurations.size(); i++)
+    {
+        workers.push_back(std::unique_ptr<Worker>(new Worker(source)));
+    }
+    finishedCount = 0;
+    winner = -1;
+    stopped = false;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workers.size(); i++)
+    {
+        threads.push_back(std::thread(&SolverPortfolio::run, this, std::ref(*workers.at(i)), i, timeout));
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto isDecided = [this, &workers]()
+        {
+            return winner >= 0 || finishedCount == workers.size();
+        };
+        if (timeout > 0)
+        {
+            done.wait_for(lock, std::chrono::milliseconds(timeout), isDecided);
+        }
+        else
+        {
+            done.wait(lock, isDecided);
+        }
+
+        // An interrupt is lost on a worker that has not started its check yet, so it is repeated
+        stopped = true;
+        while (finishedCount < workers.size())
+        {
+            for (auto& worker : workers)
+            {
+                if (!worker->finished)
+                {
+                    worker->ctx.interrupt();
+                }
+            }
+            done.wait_for(lock, std::chrono::milliseconds(PORTFOLIO_POLL_INTERVAL));
+        }
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (winner < 0)
+    {
+        lastWinner = "";
+        return unknown;
+    }
+    Worker& best = *workers.at(winner);
+    lastWinner = configurations.at(winner).name;
+    if (best.result == sat)
+    {
+        m = model(best.m, *ctx, model::translate());
+    }
+    return best.result;
+}
+
+// Get the name of the configuration that answered the last query, empty if none did
+std::string SolverPortfolio::getLastWinner() const
+{
+    return lastWinner;
+}
@@ -0,0 +1,65 @@
+#ifndef SOLVERPORTFOLIO_H
+#define SOLVERPORTFOLIO_H
+
+#define PORTFOLIO_POLL_INTERVAL 10                      // Milliseconds between interrupts of the workers still running
+#define PORTFOLIO_SEED 17                               // Random seed of the reseeded default solver
+#define PORTFOLIO_MIN_WORKERS 2                         // Configurations raced even on a single core
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <climits>
+#include <z3++.h>
+
+using namespace z3;
+
+// Races differently configured solvers on a hard query. Every configuration runs on its own thread
+// in its own context, since a Z3 context must not be used by two threads. The query is translated
+// into the contexts before the threads start. The first definite answer wins, the other workers
+// are interrupted, and the model of the winner is translated back into the caller's context
+class SolverPortfolio
+{
+    struct Configuration
+    {
+        std::string name;
+        std::string tactic;                             // Tactic the solver is built from, empty for the default solver
+        unsigned seed;                                  // Random seed of the solver, 0 for the default one
+    };
+
+    struct Worker
+    {
+        context ctx;
+        expr_vector query;
+        model m;
+        check_result result;
+        bool finished;
+
+        Worker(const expr_vector& source);
+    };
+
+    context* ctx;                                       // Context of the caller
+    std::vector<Configuration> configurations;
+    std::mutex mutex;
+    std::condition_variable done;
+    int finishedCount;
+    int winner;                                         // Index of the first worker with a definite answer, -1 for none
+    bool stopped;
+    std::string lastWinner;
+
+    void run(Worker& worker, int index, unsigned timeout);
+
+public:
+    SolverPortfolio(context& ctx, bool bitVectors);
+
+    void setContext(context& newCtx);
+
+    check_result check(const std::vector<expr>& query, model& m, unsigned timeout);
+    std::string getLastWinner() const;
+};
+
+#endif
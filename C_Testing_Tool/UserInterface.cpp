@@ -60,6 +60,59 @@ bool UserInterface::fileOpens()
     return f.is_open();
 }
 
+// Get the solver options of the configuration file in the tests folder, or the defaults if there is none
+SolverOptions UserInterface::loadSolverOptions()
+{
+    SolverOptions options;
+    if (ifstream(filePath + configFileName).is_open())
+    {
+        options.load(filePath + configFileName);
+    }
+    return options;
+}
+
+// Run the statement coverage test of every C file in the tests folder under every solver preset,
+// and under the configuration file if there is one
+void UserInterface::runBenchmark()
+{
+    vector<string> fileNames;
+    WIN32_FIND_DATAA fileData;
+    HANDLE search = FindFirstFileA((filePath + "*.c").c_str(), &fileData);
+    if (search != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            fileNames.push_back(filePath + fileData.cFileName);
+        } while (FindNextFileA(search, &fileData));
+        FindClose(search);
+    }
+
+    vector<pair<string, SolverOptions>> configurations;
+    for (auto& preset : SolverOptions::getPresetNames())
+    {
+        SolverOptions options;
+        options.applyPreset(preset);
+        configurations.push_back(make_pair(preset, options));
+    }
+    if (ifstream(filePath + configFileName).is_open())
+    {
+        configurations.push_back(make_pair(configFileName, loadSolverOptions()));
+    }
+    CoverageAnalyzer::benchmark(fileNames, configurations, 0);
+}
+
+// Check the queries captured by the coverage tests again, with the solver options of the configuration file
+void UserInterface::runReplay()
+{
+    SolverOptions options = loadSolverOptions();
+    if (options.captureDirectory.empty())
+    {
+        cout << "No capture directory: add a line 'capture = <directory>' to " << filePath + configFileName << "\n";
+        return;
+    }
+    QueryCapture::replay(options.captureDirectory, options);
+}
+
 void UserInterface::goLive()
 {
     displayMenu();
@@ -81,6 +134,25 @@ void UserInterface::goLive()
 
         case KEY_ENT:
             system("cls");
+            if (currOptionIndex == BENCHMARK_OPTION || currOptionIndex == REPLAY_OPTION)
+            {
+                cout << TEST_START_MSG;
+                if (currOptionIndex == BENCHMARK_OPTION)
+                {
+                    runBenchmark();
+                }
+                else
+                {
+                    runReplay();
+                }
+                cout << TEST_END_MSG;
+                input = _getch();
+                if (input != KEY_ESC)
+                {
+                    goLive();
+                }
+                break;
+            }
             cout << ENTER_FILENAME_MSG;
             cout << "Your file name: ";
             cin >> fileName;
@@ -132,10 +204,15 @@ void UserInterface::goLive()
                     break;
                 }
 
-                case 2: case 3:
+                case 2: case 3: case 4: case 5:
                 {
-                    int coverageOption = currOptionIndex - 2;
-                    CoverageAnalyzer covAnalyzer(fullFileName);
+                    int coverageOption = currOptionIndex % 2;
+                    SolverOptions options = loadSolverOptions();
+                    if (currOptionIndex >= 4)
+                    {
+                        options.engine = ENGINE_BMC;
+                    }
+                    CoverageAnalyzer covAnalyzer(fullFileName, 10000, options);
                     covAnalyzer.analyze(coverageOption);
                     break;
                 }
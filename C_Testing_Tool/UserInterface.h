@@ -5,6 +5,8 @@
 #define KEY_DOWN 80
 #define KEY_ENT 13
 #define KEY_ESC 27
+#define BENCHMARK_OPTION 6
+#define REPLAY_OPTION 7
 
 #include "Lexer.h"
 #include "Parser.h"
@@ -34,6 +36,7 @@ class UserInterface
     const string NO_TEST_MSG = "ERROR: This test is unavailable.\n";
 
     const string filePath = "..\\Tests\\";
+    const string configFileName = "solver.cfg";        // Solver options of the coverage tests, read from the tests folder
     string fileName;
     string fullFileName;
 
@@ -47,6 +50,10 @@ class UserInterface
 	bool isExtensionSupported();
 	bool fileOpens();
 
+    SolverOptions loadSolverOptions();
+    void runBenchmark();
+    void runReplay();
+
 public:
     UserInterface(vector<string> options);
 
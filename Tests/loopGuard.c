@@ -0,0 +1,15 @@
+/*
+1 - The loop reaches n before it ends
+0 - n is out of the range of the loop
+*/
+
+int loopGuard(int n) {
+    int i = 0;
+    int t = 0;
+    while (i < 100) {
+        if (i == n)
+            t = 1;
+        i++;
+    }
+    return t;
+}